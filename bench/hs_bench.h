@@ -0,0 +1,128 @@
+#ifndef HS_BENCH_H_
+#define HS_BENCH_H_
+
+// shared helpers for the benchmark programs in bench/
+// results are printed as one json object per line
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+        double min, max, mean, stddev, p50, p90, p99;
+        uint32_t count;
+} hs_bench_summary;
+
+static inline uint64_t
+hs_bench_now_ns()
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline int
+hs_bench_cmp_double(const void* a, const void* b)
+{
+        const double da = *(const double*)a, db = *(const double*)b;
+        return (da > db) - (da < db);
+}
+
+// nearest rank percentile of sorted samples
+static inline double
+hs_bench_percentile(const double* sorted, const uint32_t count, const double p)
+{
+        uint32_t rank = (uint32_t)ceil(p / 100.0 * count);
+        if (rank > 0) rank--;
+        if (rank >= count) rank = count - 1;
+        return sorted[rank];
+}
+
+// sorts samples in place
+static inline hs_bench_summary
+hs_bench_summarize(double* samples, const uint32_t count)
+{
+        hs_bench_summary s = {.count = count};
+        if (!count) return s;
+
+        qsort(samples, count, sizeof(double), hs_bench_cmp_double);
+
+        double sum = 0.0;
+        for (uint32_t i = 0; i < count; i++)
+                sum += samples[i];
+        s.mean = sum / count;
+
+        double var = 0.0;
+        for (uint32_t i = 0; i < count; i++)
+                var += (samples[i] - s.mean) * (samples[i] - s.mean);
+        s.stddev = count > 1 ? sqrt(var / (count - 1)) : 0.0;
+
+        s.min = samples[0];
+        s.max = samples[count - 1];
+        s.p50 = hs_bench_percentile(samples, count, 50.0);
+        s.p90 = hs_bench_percentile(samples, count, 90.0);
+        s.p99 = hs_bench_percentile(samples, count, 99.0);
+        return s;
+}
+
+// prints the summary fields without braces, values are suffixed with unit
+static inline void
+hs_bench_summary_print_json(FILE* out, const hs_bench_summary s, const char* unit)
+{
+        fprintf(out, "\"samples\":%u,\"min_%s\":%.3f,\"p50_%s\":%.3f,\"p90_%s\":%.3f,"
+                "\"p99_%s\":%.3f,\"max_%s\":%.3f,\"mean_%s\":%.3f,\"stddev_%s\":%.3f",
+                s.count, unit, s.min, unit, s.p50, unit, s.p90,
+                unit, s.p99, unit, s.max, unit, s.mean, unit, s.stddev);
+}
+
+// baseline files are plain text, one "<name> <n> <ns per op>" line per result
+
+typedef struct {
+        char name[64];
+        uint32_t n;
+        double ns_per_op;
+} hs_bench_baseline_entry;
+
+typedef struct {
+        hs_bench_baseline_entry* entries;
+        uint32_t count;
+} hs_bench_baseline;
+
+static inline hs_bench_baseline
+hs_bench_baseline_load(const char* file_path)
+{
+        hs_bench_baseline baseline = {0};
+        FILE* file = fopen(file_path, "r");
+        if (!file) {
+                fprintf(stderr, "---error reading baseline \"%s\"---\n", file_path);
+                return baseline;
+        }
+
+        uint32_t cap = 64;
+        baseline.entries = malloc(sizeof(hs_bench_baseline_entry) * cap);
+        hs_bench_baseline_entry e;
+        while (fscanf(file, "%63s %u %lf", e.name, &e.n, &e.ns_per_op) == 3) {
+                if (baseline.count == cap) {
+                        cap *= 2;
+                        baseline.entries = realloc(baseline.entries, sizeof(hs_bench_baseline_entry) * cap);
+                }
+                baseline.entries[baseline.count++] = e;
+        }
+
+        fclose(file);
+        return baseline;
+}
+
+static inline const hs_bench_baseline_entry*
+hs_bench_baseline_find(const hs_bench_baseline baseline, const char* name, const uint32_t n)
+{
+        for (uint32_t i = 0; i < baseline.count; i++)
+                if (baseline.entries[i].n == n && !strcmp(baseline.entries[i].name, name))
+                        return &baseline.entries[i];
+        return NULL;
+}
+
+#endif // HS_BENCH_H_
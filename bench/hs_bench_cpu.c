@@ -0,0 +1,599 @@
+// CPU micro-benchmarks for math, containers, collision and generation.
+// No GL context is created, the two GL calls made by hs_aroom_set_tilemap are stubbed.
+//
+// build (from the repository root):
+//   cc -O2 -DHS_GLFW_OSMESA bench/hs_bench_cpu.c -o hs_bench_cpu -lm -ldl -lpthread
+// run:
+//   ./hs_bench_cpu [--runs N] [--warmup N] [--threshold percent]
+//                  [--baseline file] [--write-baseline file] > cpu.jsonl
+//
+// with --baseline the exit code is 1 if any median is slower than the threshold.
+
+#define HS_IMPL
+#include "../hs_graphics.h"
+#include "../hs_nav.h"
+#include "hs_bench.h"
+
+typedef struct {
+        const char* name;
+        void (*setup)(const uint32_t n);  // untimed, once per n
+        void (*reset)(const uint32_t n);  // untimed, before every run
+        void (*run)(const uint32_t n);
+        uint64_t (*ops)(const uint32_t n);
+        uint32_t sweep[4];                // zero terminated
+} bench;
+
+static volatile float sink;
+
+static mat4 mats[2][64];
+static vec2* vecs;
+static hs_rect2* rects;
+static hs_rect2* rects_start;
+static hs_rect2* rooms;
+static hs_aabb2i* bsp_rects;
+static hs_tilemap tilemap;
+static hs_aroom aroom;
+static hs_grid grid;
+
+static void APIENTRY stub_BindBuffer(GLenum target, GLuint buffer) {}
+static void APIENTRY stub_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {}
+
+static uint64_t ops_n(const uint32_t n)    {return n;}
+static uint64_t ops_pairs(const uint32_t n) {return (uint64_t)n * n;}
+static uint64_t ops_tiles(const uint32_t n) {return (uint64_t)n * n;}
+
+static void
+mat4_setup(const uint32_t n)
+{
+        for (uint32_t i = 0; i < 64; i++)
+                for (uint32_t j = 0; j < 16; j++) {
+                        mats[0][i][j / 4][j % 4] = random_float();
+                        mats[1][i][j / 4][j % 4] = random_float();
+                }
+}
+
+static void
+mat4_run(const uint32_t n)
+{
+        mat4 res;
+        for (uint32_t i = 0; i < n; i++) {
+                mat4_mul(res, mats[0][i % 64], mats[1][(i * 7) % 64]);
+                sink += res[i % 4][(i / 4) % 4];
+        }
+}
+
+static void
+vec2_setup(const uint32_t n)
+{
+        free(vecs);
+        vecs = malloc(sizeof(vec2) * n);
+        assert(vecs);
+        for (uint32_t i = 0; i < n; i++)
+                vecs[i] = (vec2){random_float_negative(), random_float_negative()};
+}
+
+static void
+vec2_run(const uint32_t n)
+{
+        vec2 acc = {0};
+        for (uint32_t i = 1; i < n; i++) {
+                vec2 v = vec2_sub(vecs[i], vecs[i - 1]);
+                v = vec2_add(vec2_scale(vec2_norm(v), 0.5f), vec2_mul(vecs[i], v));
+                acc = vec2_add(acc, v);
+                sink += vec2_dot(acc, v) + vec2_len(v);
+        }
+}
+
+static void
+dynarr_run(const uint32_t n)
+{
+        hs_dynarr arr = hs_dynarr_init(uint32_t, 1);
+        for (uint32_t i = 0; i < n; i++) {
+                hs_dynarr_push(arr, uint32_t, i);
+        }
+        if (arr.len) sink += hs_dynarr_front(arr, uint32_t);
+        hs_dynarr_free(arr);
+}
+
+static void
+collide_setup(const uint32_t n)
+{
+        free(rects);
+        free(rects_start);
+        rects = malloc(sizeof(hs_rect2) * n);
+        rects_start = malloc(sizeof(hs_rect2) * n);
+        assert(rects && rects_start);
+
+        // dense enough that a good share of pairs overlap
+        const float area = sqrtf(n) * 0.05f;
+        for (uint32_t i = 0; i < n; i++)
+                rects_start[i] = (hs_rect2){
+                        .pos = {random_float_negative() * area, random_float_negative() * area},
+                        .half_size = {0.05f, 0.05f},
+                };
+}
+
+static void
+collide_reset(const uint32_t n)
+{
+        memcpy(rects, rects_start, sizeof(hs_rect2) * n);
+}
+
+static void
+collide_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < n; i++)
+                for (uint32_t j = 0; j < n; j++)
+                        if (i != j) hs_entity2_collide(&rects[i], &rects[j]);
+        sink += rects[0].pos.x;
+}
+
+#define INSIDE_ENTITIES 1000
+
+static void
+inside_setup(const uint32_t n)
+{
+        collide_setup(INSIDE_ENTITIES);
+        free(rooms);
+        rooms = malloc(sizeof(hs_rect2) * n);
+        assert(rooms);
+        for (uint32_t i = 0; i < n; i++)
+                rooms[i] = (hs_rect2){
+                        .pos = {random_float_negative() * 4.0f, random_float_negative() * 4.0f},
+                        .half_size = {0.2f + random_float() * 0.3f, 0.2f + random_float() * 0.3f},
+                };
+}
+
+static void
+inside_reset(const uint32_t n)
+{
+        collide_reset(INSIDE_ENTITIES);
+}
+
+static void
+inside_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < INSIDE_ENTITIES; i++)
+                hs_entity2_force_inside_rects(&rects[i], rooms, n);
+        sink += rects[0].pos.x;
+}
+
+static uint64_t ops_inside(const uint32_t n) {return (uint64_t)INSIDE_ENTITIES * n;}
+
+static void
+slide_setup(const uint32_t n)
+{
+        inside_setup(n);
+        vec2_setup(INSIDE_ENTITIES);
+        for (uint32_t i = 0; i < INSIDE_ENTITIES; i++)
+                vecs[i] = vec2_scale(vecs[i], 2.0f);
+}
+
+static void
+slide_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < INSIDE_ENTITIES; i++)
+                hs_entity2_move_and_slide(&rects[i], vecs[i], rooms, n);
+        sink += rects[0].pos.x;
+}
+
+static void
+bsp_setup(const uint32_t n)
+{
+        free(bsp_rects);
+        bsp_rects = malloc(sizeof(hs_aabb2i) * n);
+        assert(bsp_rects);
+}
+
+static void
+bsp_run(const uint32_t n)
+{
+        bsp_rects[0] = (hs_aabb2i){.bl = {0, 0}, .tr = {8192, 8192}};
+        uint32_t count = 1;
+        while (count < n && hs_bsp_recti_split_in_place_append(bsp_rects, count, (vec2i){4, 4}))
+                count++;
+        sink += count;
+}
+
+static void
+tilemap_setup(const uint32_t n)
+{
+        free(tilemap.vertices);
+        tilemap = (hs_tilemap){
+                .width = n, .height = n,
+                .tileset_width = 16, .tileset_height = 16,
+                .sp.p = 1, // skip creating GL objects
+        };
+        hs_tilemap_init(&tilemap, 0);
+
+        free(aroom.data);
+        aroom = (hs_aroom){.width = n, .height = n, .layers = 1};
+        aroom.data = malloc(n * n);
+        assert(aroom.data);
+        for (uint32_t i = 0; i < n * n; i++)
+                aroom.data[i] = rand();
+}
+
+static void
+tilemap_set_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < n * n; i++)
+                hs_tilemap_set(&tilemap, i, aroom.data[i]);
+}
+
+static void
+aroom_set_tilemap_run(const uint32_t n)
+{
+        hs_aroom_set_tilemap(aroom, &tilemap, 1);
+}
+
+static void
+aroom_set_tilemap_mt_run(const uint32_t n)
+{
+        hs_aroom_set_tilemap_mt(aroom, &tilemap, 1, 0);
+}
+
+#define GRID_SIZE 256
+
+static void
+grid_setup(const uint32_t n)
+{
+        collide_setup(n);
+        for (uint32_t i = 0; i < n; i++)
+                rects_start[i].pos = (vec2){random_float() * GRID_SIZE, random_float() * GRID_SIZE};
+
+        free(aroom.data);
+        aroom = (hs_aroom){.width = GRID_SIZE, .height = GRID_SIZE, .layers = 1};
+        aroom.data = malloc(GRID_SIZE * GRID_SIZE);
+        assert(aroom.data);
+        for (uint32_t i = 0; i < GRID_SIZE * GRID_SIZE; i++)
+                aroom.data[i] = rand() % 8 ? 0 : 1;
+
+        hs_grid_free(&grid);
+        const uint8_t solid[] = {1};
+        grid = hs_grid_from_aroom(aroom, 1, solid, 1);
+}
+
+static void
+grid_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < n; i++)
+                hs_grid_rect_resolve(grid, &rects[i]);
+        sink += rects[0].pos.x;
+}
+
+static hs_ray2* rays;
+static hs_grid_hit* hits;
+
+static void
+raycast_setup(const uint32_t n)
+{
+        grid_setup(1);
+        free(rays);
+        free(hits);
+        rays = malloc(sizeof(hs_ray2) * n);
+        hits = malloc(sizeof(hs_grid_hit) * n);
+        assert(rays && hits);
+        for (uint32_t i = 0; i < n; i++)
+                rays[i] = (hs_ray2){
+                        .origin = {random_float() * GRID_SIZE, random_float() * GRID_SIZE},
+                        .dir = {random_float_negative(), random_float_negative()},
+                        .max_dist = GRID_SIZE,
+                };
+}
+
+static void
+raycast_run(const uint32_t n)
+{
+        hs_grid_raycast_batch(grid, rays, hits, n, 0);
+        sink += hits[0].dist;
+}
+
+static hs_flow_field flow;
+static vec2i flow_target;
+
+static void
+flow_setup(const uint32_t n)
+{
+        hs_grid_free(&grid);
+        grid = hs_grid_create(n, n);
+        for (uint32_t y = 0; y < n; y++)
+                for (uint32_t x = 0; x < n; x++)
+                        hs_grid_set(&grid, x, y, rand() % 8 == 0);
+
+        flow_target = (vec2i){n / 2, n / 2};
+        hs_grid_set(&grid, flow_target.x, flow_target.y, false);
+        hs_grid_set(&grid, flow_target.x + 1, flow_target.y, false);
+
+        hs_flow_field_free(&flow);
+        flow = hs_flow_field_create(n, n);
+        hs_flow_field_build(&flow, grid, &flow_target, 1);
+}
+
+static void
+flow_build_run(const uint32_t n)
+{
+        hs_flow_field_build(&flow, grid, &flow_target, 1);
+        sink += flow.dir[0];
+}
+
+// the target steps back and forth between two cells
+static void
+flow_retarget_run(const uint32_t n)
+{
+        flow_target.x += flow_target.x == (int32_t)n / 2 ? 1 : -1;
+        hs_flow_field_retarget(&flow, grid, flow_target);
+        sink += flow.dir[0];
+}
+
+static hs_fov fov;
+
+// n is the view radius
+static void
+fov_setup(const uint32_t n)
+{
+        grid_setup(1);
+        if (fov.visible.bits) hs_fov_free(&fov);
+        fov = hs_fov_create(GRID_SIZE, GRID_SIZE);
+}
+
+static void
+fov_run(const uint32_t n)
+{
+        for (uint32_t i = 0; i < 64; i++)
+                hs_fov_compute(&fov, grid, (vec2i){GRID_SIZE / 2 + i % 8, GRID_SIZE / 2 + i / 8}, n);
+        sink += fov.visible.bits[0];
+}
+
+static uint64_t ops_fov(const uint32_t n) {return 64;}
+
+static void
+los_run(const uint32_t n)
+{
+        uint32_t seen = 0;
+        for (uint32_t i = 0; i < INSIDE_ENTITIES; i++) {
+                const vec2i enemy = hs_grid_cell(grid, rects[i].pos);
+                seen += hs_grid_los(grid, (vec2i){GRID_SIZE / 2, GRID_SIZE / 2}, enemy);
+        }
+        sink += seen;
+}
+
+static uint64_t ops_los(const uint32_t n) {return INSIDE_ENTITIES;}
+
+#define NAV_QUERIES 256
+
+static hs_nav nav;
+static hs_dynarr nav_path;
+static vec2i nav_ends[NAV_QUERIES][2];
+
+// bsp rooms walled off from each other with a door in the middle of two sides
+static void
+nav_setup(const uint32_t n)
+{
+        hs_grid_free(&grid);
+        grid = hs_grid_create(n, n);
+
+        hs_aabb2i* rooms = malloc(sizeof(hs_aabb2i) * n);
+        assert(rooms);
+        rooms[0] = (hs_aabb2i){.bl = {0, 0}, .tr = {n - 1, n - 1}};
+        uint32_t room_count = 1;
+        while (room_count < n / 4 && hs_bsp_recti_split_in_place_append(rooms, room_count, (vec2i){6, 6}))
+                room_count++;
+
+        for (uint32_t r = 0; r < room_count; r++) {
+                const hs_aabb2i a = rooms[r];
+                for (int32_t x = a.bl.x; x <= a.tr.x; x++) {
+                        hs_grid_set(&grid, x, a.bl.y, true);
+                        hs_grid_set(&grid, x, a.tr.y, true);
+                }
+                for (int32_t y = a.bl.y; y <= a.tr.y; y++) {
+                        hs_grid_set(&grid, a.bl.x, y, true);
+                        hs_grid_set(&grid, a.tr.x, y, true);
+                }
+        }
+        for (uint32_t r = 0; r < room_count; r++) {
+                const hs_aabb2i a = rooms[r];
+                const vec2i mid = {(a.bl.x + a.tr.x) / 2, (a.bl.y + a.tr.y) / 2};
+                if (a.tr.x + 1 < (int32_t)n) {
+                        hs_grid_set(&grid, a.tr.x, mid.y, false);
+                        hs_grid_set(&grid, a.tr.x + 1, mid.y, false);
+                }
+                if (a.tr.y + 1 < (int32_t)n) {
+                        hs_grid_set(&grid, mid.x, a.tr.y, false);
+                        hs_grid_set(&grid, mid.x, a.tr.y + 1, false);
+                }
+        }
+
+        for (uint32_t q = 0; q < NAV_QUERIES; q++)
+                for (uint32_t e = 0; e < 2; e++) {
+                        const hs_aabb2i a = rooms[rand() % room_count];
+                        nav_ends[q][e] = (vec2i){(a.bl.x + a.tr.x) / 2, (a.bl.y + a.tr.y) / 2};
+                }
+
+        if (nav.room_of) hs_nav_free(&nav);
+        nav = hs_nav_create(grid, rooms, room_count);
+        if (!nav_path.data) nav_path = hs_dynarr_init(vec2i, 256);
+        free(rooms);
+}
+
+static void
+nav_run(const uint32_t n)
+{
+        hs_nav_cache_clear(&nav);
+        for (uint32_t q = 0; q < NAV_QUERIES; q++)
+                sink += hs_nav_path(&nav, grid, nav_ends[q][0], nav_ends[q][1], &nav_path);
+}
+
+static uint64_t ops_nav(const uint32_t n) {return NAV_QUERIES;}
+
+typedef struct {
+        vec2 pos;
+        uint8_t layer;
+        uint32_t shader, tex;
+} sprite;
+
+static sprite* sprites;
+static hs_draw_order draw_order;
+
+static void
+sprite_setup(const uint32_t n)
+{
+        free(sprites);
+        sprites = malloc(sizeof(sprite) * n);
+        assert(sprites);
+        for (uint32_t i = 0; i < n; i++)
+                sprites[i] = (sprite){
+                        .pos = {random_float_negative(), random_float_negative()},
+                        .layer = rand() % 4, .shader = 1 + rand() % 2, .tex = 1 + rand() % 8,
+                };
+}
+
+static void
+draw_order_run(const uint32_t n)
+{
+        hs_draw_order_clear(&draw_order);
+        for (uint32_t i = 0; i < n; i++) {
+                const sprite s = sprites[i];
+                hs_draw_order_push(&draw_order,
+                                   hs_draw_key(s.layer, hs_draw_depth_y(s.pos.y, -1.0f, 1.0f), s.shader, s.tex), i);
+        }
+        hs_draw_order_sort(&draw_order);
+        sink += draw_order.order[n / 2];
+}
+
+static int
+sprite_cmp(const void* a, const void* b)
+{
+        const sprite* sa = a;
+        const sprite* sb = b;
+        if (sa->layer != sb->layer) return sa->layer < sb->layer ? -1 : 1;
+        if (sa->pos.y != sb->pos.y) return sa->pos.y > sb->pos.y ? -1 : 1;
+        if (sa->shader != sb->shader) return sa->shader < sb->shader ? -1 : 1;
+        return (sa->tex > sb->tex) - (sa->tex < sb->tex);
+}
+
+// what games do without hs_draw_order, sorting the entity structs themselves
+static void
+qsort_run(const uint32_t n)
+{
+        qsort(sprites, n, sizeof(sprite), sprite_cmp);
+        sink += sprites[n / 2].pos.x;
+}
+
+static void
+qsort_reset(const uint32_t n)
+{
+        srand(n);
+        sprite_setup(n);
+}
+
+static const bench benches[] = {
+        {"mat4_mul",                      mat4_setup,    NULL,          mat4_run,             ops_n,      {4096}},
+        {"vec2_ops",                      vec2_setup,    NULL,          vec2_run,             ops_n,      {1024, 65536, 1048576}},
+        {"hs_dynarr_push",                NULL,          NULL,          dynarr_run,           ops_n,      {1024, 65536, 1048576}},
+        {"hs_entity2_collide",            collide_setup, collide_reset, collide_run,          ops_pairs,  {64, 256, 1024}},
+        {"hs_entity2_force_inside_rects", inside_setup,  inside_reset,  inside_run,           ops_inside, {8, 64, 512}},
+        {"hs_entity2_move_and_slide",     slide_setup,   inside_reset,  slide_run,            ops_inside, {8, 64, 512}},
+        {"hs_bsp_recti_split",            bsp_setup,     NULL,          bsp_run,              ops_n,      {64, 512, 4096}},
+        {"hs_tilemap_set",                tilemap_setup, NULL,          tilemap_set_run,      ops_tiles,  {64, 256, 1024}},
+        {"hs_aroom_set_tilemap",          tilemap_setup, NULL,          aroom_set_tilemap_run, ops_tiles, {64, 256, 1024}},
+        {"hs_aroom_set_tilemap_mt",       tilemap_setup, NULL,          aroom_set_tilemap_mt_run, ops_tiles, {256, 1024, 4096}},
+        {"hs_grid_rect_resolve",          grid_setup,    collide_reset, grid_run,             ops_n,      {1024, 65536}},
+        {"hs_grid_raycast_batch",         raycast_setup, NULL,          raycast_run,          ops_n,      {1024, 65536}},
+        {"hs_flow_field_build",           flow_setup,    NULL,          flow_build_run,       ops_tiles,  {64, 256, 1024}},
+        {"hs_flow_field_retarget",        flow_setup,    NULL,          flow_retarget_run,    ops_tiles,  {64, 256, 1024}},
+        {"hs_fov_compute",                fov_setup,     NULL,          fov_run,              ops_fov,    {8, 16, 32}},
+        {"hs_grid_los",                   grid_setup,    collide_reset, los_run,              ops_los,    {INSIDE_ENTITIES}},
+        {"hs_nav_path",                   nav_setup,     NULL,          nav_run,              ops_nav,    {128, 512, 2048}},
+        {"hs_draw_order_sort",            sprite_setup,  NULL,          draw_order_run,       ops_n,      {1024, 16384, 65536}},
+        {"qsort_sprites",                 NULL,          qsort_reset,   qsort_run,            ops_n,      {1024, 16384, 65536}},
+};
+
+int
+main(int argc, char** argv)
+{
+        uint32_t runs = 15, warmup = 3;
+        double threshold = 10.0;
+        const char* baseline_path = NULL;
+        const char* write_baseline_path = NULL;
+
+        for (int i = 1; i + 1 < argc; i += 2) {
+                if      (!strcmp(argv[i], "--runs"))           runs = atoi(argv[i + 1]);
+                else if (!strcmp(argv[i], "--warmup"))         warmup = atoi(argv[i + 1]);
+                else if (!strcmp(argv[i], "--threshold"))      threshold = atof(argv[i + 1]);
+                else if (!strcmp(argv[i], "--baseline"))       baseline_path = argv[i + 1];
+                else if (!strcmp(argv[i], "--write-baseline")) write_baseline_path = argv[i + 1];
+                else {
+                        fprintf(stderr, "unknown option %s\n", argv[i]);
+                        return 2;
+                }
+        }
+        if (!runs) runs = 1;
+
+        glad_glBindBuffer = stub_BindBuffer;
+        glad_glBufferData = stub_BufferData;
+
+        hs_bench_baseline baseline = {0};
+        if (baseline_path) baseline = hs_bench_baseline_load(baseline_path);
+
+        FILE* baseline_out = NULL;
+        if (write_baseline_path) {
+                baseline_out = fopen(write_baseline_path, "w");
+                if (!baseline_out) {
+                        fprintf(stderr, "---error writing baseline \"%s\"---\n", write_baseline_path);
+                        return 2;
+                }
+        }
+
+        double* samples = malloc(sizeof(double) * runs);
+        assert(samples);
+        uint32_t regressions = 0;
+
+        for (uint32_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+                const bench* bench = &benches[b];
+
+                for (uint32_t s = 0; s < 4 && bench->sweep[s]; s++) {
+                        const uint32_t n = bench->sweep[s];
+                        srand(1);
+                        if (bench->setup) bench->setup(n);
+
+                        for (uint32_t r = 0; r < warmup + runs; r++) {
+                                if (bench->reset) bench->reset(n);
+                                srand(r);
+
+                                const uint64_t start = hs_bench_now_ns();
+                                bench->run(n);
+                                const uint64_t end = hs_bench_now_ns();
+
+                                if (r >= warmup) samples[r - warmup] = (double)(end - start);
+                        }
+
+                        const hs_bench_summary summary = hs_bench_summarize(samples, runs);
+                        const double ns_per_op = summary.p50 / bench->ops(n);
+
+                        printf("{\"bench\":\"cpu\",\"name\":\"%s\",\"n\":%u,\"ops\":%llu,",
+                               bench->name, n, (unsigned long long)bench->ops(n));
+                        hs_bench_summary_print_json(stdout, summary, "ns");
+                        printf(",\"ns_per_op\":%.4f", ns_per_op);
+
+                        const hs_bench_baseline_entry* base = hs_bench_baseline_find(baseline, bench->name, n);
+                        if (base) {
+                                const double delta = (ns_per_op / base->ns_per_op - 1.0) * 100.0;
+                                const uint32_t regressed = delta > threshold;
+                                regressions += regressed;
+                                printf(",\"baseline_ns_per_op\":%.4f,\"delta_percent\":%.2f,\"regression\":%s",
+                                       base->ns_per_op, delta, regressed ? "true" : "false");
+                        }
+                        printf("}\n");
+                        fflush(stdout);
+
+                        if (baseline_out)
+                                fprintf(baseline_out, "%s %u %.4f\n", bench->name, n, ns_per_op);
+                }
+        }
+
+        if (baseline_out) fclose(baseline_out);
+        free(baseline.entries);
+        free(samples);
+        return regressions ? 1 : 0;
+}
@@ -0,0 +1,336 @@
+// Headless rendering benchmark, draws generated rooms through hs_tilemap,
+// hs_layered_tilemap, hs_dyn_tilemap, a fogged tilemap, a lit tilemap, gpu particles, text labels
+// and sprites along a scripted camera path.
+//
+// build (from the repository root):
+//   cc -O2 -DHS_GLFW_OSMESA bench/hs_bench_render.c -o hs_bench_render -lm -ldl -lpthread
+// run:
+//   ./hs_bench_render [map size] [frames] [sprites] > render.jsonl
+//
+// needs libOSMesa at runtime, no display or GPU.
+
+#define HS_IMPL
+#define HS_GL_STATS
+#include "../hs_graphics.h"
+#include "../hs_grid.h"
+#include "../hs_text.h"
+#include "hs_bench.h"
+
+#define LAYERS 3
+#define WARMUP_FRAMES 10
+#define TILE_SIZE 0.01f
+#define DYN_RADIUS 64
+#define FOV_RADIUS 24
+#define LIGHTS 512
+#define LIGHT_RADIUS 0.16f
+#define PARTICLES 100000
+#define LABELS 2000
+
+enum scenario {
+        SCENARIO_TILEMAP,
+        SCENARIO_TILEMAP_RESKIN,
+        SCENARIO_LAYERED_TILEMAP,
+        SCENARIO_DYN_TILEMAP,
+        SCENARIO_DYN_TILEMAP_STREAM,
+        SCENARIO_DYN_TILEMAP_COMPACT,
+        SCENARIO_TILEMAP_FOG,
+        SCENARIO_TILEMAP_LIGHTING,
+        SCENARIO_PARTICLES,
+        SCENARIO_TEXT,
+        SCENARIO_SPRITES,
+        SCENARIO_COUNT,
+};
+
+static const char* scenario_names[SCENARIO_COUNT] = {
+        [SCENARIO_TILEMAP]        = "tilemap",
+        [SCENARIO_TILEMAP_RESKIN] = "tilemap_reskin",
+        [SCENARIO_LAYERED_TILEMAP] = "layered_tilemap",
+        [SCENARIO_DYN_TILEMAP]    = "dyn_tilemap",
+        [SCENARIO_DYN_TILEMAP_STREAM] = "dyn_tilemap_stream",
+        [SCENARIO_DYN_TILEMAP_COMPACT] = "dyn_tilemap_compact",
+        [SCENARIO_TILEMAP_FOG]    = "tilemap_fog",
+        [SCENARIO_TILEMAP_LIGHTING] = "tilemap_lighting",
+        [SCENARIO_PARTICLES]      = "particles",
+        [SCENARIO_TEXT]           = "text",
+        [SCENARIO_SPRITES]        = "sprites",
+};
+
+static hs_aroom
+generate_aroom(const uint16_t size)
+{
+        hs_aroom aroom = {.width = size, .height = size, .layers = LAYERS};
+        const uint32_t layer_size = (uint32_t)size * size;
+        aroom.data = malloc(layer_size * LAYERS);
+        assert(aroom.data);
+
+        // walls everywhere, then carve bsp rooms into the first layer
+        memset(aroom.data, 1, layer_size);
+        for (uint32_t i = layer_size; i < layer_size * LAYERS; i++)
+                aroom.data[i] = rand() % 8 ? 0 : rand() % 255;
+
+        const uint32_t room_count = size / 4;
+        hs_aabb2i* rooms = malloc(sizeof(hs_aabb2i) * room_count);
+        assert(rooms);
+        rooms[0] = (hs_aabb2i){.bl = {1, 1}, .tr = {size - 2, size - 2}};
+
+        uint32_t rooms_made = 1;
+        while (rooms_made < room_count &&
+               hs_bsp_recti_split_in_place_append(rooms, rooms_made, (vec2i){6, 6}))
+                rooms_made++;
+
+        for (uint32_t r = 0; r < rooms_made; r++)
+                for (int32_t y = rooms[r].bl.y + 1; y < rooms[r].tr.y; y++)
+                        for (int32_t x = rooms[r].bl.x + 1; x < rooms[r].tr.x; x++)
+                                aroom.data[x + y * size] = 2 + rand() % 4;
+
+        free(rooms);
+        return aroom;
+}
+
+// 16x16 cells of 8x8 texels, every glyph a box of its own width so advances differ
+static hs_font
+generate_font()
+{
+        uint8_t* rgba = malloc(128 * 128 * 4);
+        assert(rgba);
+        for (uint32_t y = 0; y < 128; y++)
+                for (uint32_t x = 0; x < 128; x++) {
+                        const uint32_t glyph = x / 8 + y / 8 * 16;
+                        uint8_t* texel = &rgba[(x + y * 128) * 4];
+                        texel[0] = texel[1] = texel[2] = 255;
+                        texel[3] = x % 8 <= glyph % 7 && y % 8 >= 1 ? 255 : 0;
+                }
+
+        hs_font font = hs_font_create_data(rgba, 128, 128, 16, 16, 0, 0);
+        free(rgba);
+        return font;
+}
+
+static vec2
+camera_path(const uint32_t frame, const uint32_t frames, const float radius)
+{
+        const float t = TWO_PI * (float)frame / (float)frames;
+        return (vec2){cosf(t) * radius, sinf(2.0f * t) * radius * 0.5f};
+}
+
+int
+main(int argc, char** argv)
+{
+        const uint16_t size    = argc > 1 ? atoi(argv[1]) : 1024;
+        const uint32_t frames  = argc > 2 ? atoi(argv[2]) : 300;
+        const uint32_t sprites = argc > 3 ? atoi(argv[3]) : 10000;
+
+        hs_game_data gd = {.width = 1280, .height = 720};
+        hs_init(&gd, "hs_bench_render", NULL, HS_HEADLESS | HS_NO_VSYNC | HS_BLEND_MODE);
+
+        srand(1);
+        hs_aroom aroom = generate_aroom(size);
+
+        hs_tilemap tilemaps[LAYERS] = {0};
+        for (uint32_t l = 0; l < LAYERS; l++) {
+                tilemaps[l] = (hs_tilemap){
+                        .tile_width = TILE_SIZE, .tile_height = TILE_SIZE,
+                        .tileset_width = 16, .tileset_height = 16,
+                };
+                hs_aroom_to_tilemap(aroom, &tilemaps[l], l + 1);
+        }
+
+        hs_layered_tilemap layered = {
+                .tile_width = TILE_SIZE, .tile_height = TILE_SIZE,
+                .tileset_width = 16, .tileset_height = 16,
+                .skip_empty = true,
+        };
+        hs_aroom_to_layered_tilemap(aroom, &layered);
+
+        hs_dyn_tilemap dyn = {
+                .tile_width = TILE_SIZE, .tile_height = TILE_SIZE,
+                .tileset_width = 16, .tileset_height = 16,
+        };
+        hs_dyn_tilemap dyn_stream = dyn;
+        hs_dyn_tilemap dyn_compact = dyn;
+        dyn_compact.compact = true;
+        hs_dyn_tilemap_init(&dyn, sq(DYN_RADIUS * 2));
+        hs_dyn_tilemap_init_stream(&dyn_stream, sq(DYN_RADIUS * 2));
+        hs_dyn_tilemap_init_stream(&dyn_compact, sq(DYN_RADIUS * 2));
+
+        // the walls of the first layer block sight, the fog follows the camera
+        const uint8_t walls[] = {1};
+        hs_grid grid = hs_grid_from_aroom(aroom, 1, walls, 1);
+        hs_grid_align_tilemap(&grid, tilemaps[0]);
+        hs_fov fov = hs_fov_create(size, size);
+        hs_fog fog = hs_fog_create(size, size, HS_FOG_HIDDEN, GL_LINEAR);
+        hs_tilemap fogged = tilemaps[0];
+        fogged.sp = (hs_shader_program){0};
+        fogged.vertices = NULL;
+        hs_aroom_to_tilemap(aroom, &fogged, 1);
+        hs_fog_tilemap_sp_set(&fogged, fog);
+
+        // lights wander around the camera in a half resolution buffer, the walls cast shadows
+        hs_lighting lighting = {.ambient = {0.15f, 0.15f, 0.2f}};
+        hs_lighting_init(&lighting, gd.width, gd.height, 0.5f, LIGHTS);
+        const uint32_t occluders = hs_grid_tex_create(grid);
+        hs_lighting_grid_set(&lighting, occluders, grid);
+
+        // a fountain following the camera, simulated and drawn without any uploads
+        hs_particles particles;
+        hs_particles_init(&particles, PARTICLES, (hs_particle_emitter){
+                .radius = 0.05f, .vel = {0.0f, 0.8f}, .vel_spread = 0.4f, .gravity = {0.0f, -1.0f},
+                .life_min = 1.0f, .life_max = 2.0f, .size_start = 0.004f, .size_end = 0.001f,
+                .color_start = {1.0f, 1.0f, 1.0f, 1.0f}, .color_end = {1.0f, 0.3f, 0.0f, 0.0f},
+                .tile = 0, .frames = 4, .emitting = true,
+        }, 16.0f, 16.0f);
+
+        // half the labels are static name tags from cached runs, the other half change every frame
+        hs_font font = generate_font();
+        hs_text_batch text;
+        hs_text_init(&text, &font, LABELS * 16);
+        hs_text_run name_tag = hs_text_run_create(&font, "Anders Tale");
+
+        hs_shader_program sprite_sp = hs_sp_sprite_create(16.0f, 16.0f, 800.0f);
+        const uint32_t u_sprite_tex = hs_uniform_create(sprite_sp.p, "u_tex");
+        hs_tex_uniform_set(u_sprite_tex, 0);
+
+        const float world_radius = size * TILE_SIZE * 0.8f;
+        double* samples = malloc(sizeof(double) * frames);
+        assert(samples);
+
+        for (uint32_t scenario = 0; scenario < SCENARIO_COUNT; scenario++) {
+                uint64_t draw_calls = 0, state_changes = 0, upload_bytes = 0, vertices = 0;
+
+                for (uint32_t frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+                        const vec2 cam = camera_path(frame, frames, world_radius);
+                        const vec2 view = {-cam.x, -cam.y};
+                        const uint64_t start = hs_bench_now_ns();
+
+                        hs_clear(0.0f, 0.0f, 0.0f, 1.0f, 0);
+                        hs_tex2d_activate(hs_default_missing_tex, GL_TEXTURE0);
+
+                        switch (scenario) {
+                        case SCENARIO_TILEMAP_RESKIN:
+                                hs_aroom_set_tilemap(aroom, &tilemaps[0], 1 + frame % LAYERS);
+                                // fallthrough
+                        case SCENARIO_TILEMAP:
+                                for (uint32_t l = 0; l < LAYERS; l++) {
+                                        hs_uniform_sp_vec2_set(tilemaps[l].sp.p, tilemaps[l].sp.coord.view, view);
+                                        hs_tilemap_draw(tilemaps[l]);
+                                }
+                                break;
+                        case SCENARIO_LAYERED_TILEMAP:
+                                hs_tex2d_array_activate(layered.tex, GL_TEXTURE0);
+                                hs_uniform_sp_vec2_set(layered.sp.p, layered.sp.coord.view, view);
+                                hs_layered_tilemap_draw(layered);
+                                break;
+                        case SCENARIO_DYN_TILEMAP:
+                        case SCENARIO_DYN_TILEMAP_STREAM:
+                        case SCENARIO_DYN_TILEMAP_COMPACT: {
+                                hs_dyn_tilemap* d = scenario == SCENARIO_DYN_TILEMAP        ? &dyn :
+                                                    scenario == SCENARIO_DYN_TILEMAP_STREAM ? &dyn_stream : &dyn_compact;
+                                // dyn tilemap positions start at the origin, the static tilemap is centered
+                                const vec2i center = {
+                                        (cam.x + size * TILE_SIZE) / (2.0f * TILE_SIZE),
+                                        (cam.y + size * TILE_SIZE) / (2.0f * TILE_SIZE),
+                                };
+                                hs_dyn_tilemap_clear(d);
+                                for (int32_t y = center.y - DYN_RADIUS; y < center.y + DYN_RADIUS; y++) {
+                                        if (y < 0 || y >= size) continue;
+                                        for (int32_t x = center.x - DYN_RADIUS; x < center.x + DYN_RADIUS; x++) {
+                                                if (x < 0 || x >= size) continue;
+                                                hs_dyn_tilemap_push(d, (vec2i){x, y}, hs_aroom_get_xy(aroom, x, y));
+                                        }
+                                }
+                                hs_dyn_tilemap_update_vbo(*d);
+                                const vec2 dyn_view = vec2_sub(view, (vec2){size * TILE_SIZE, size * TILE_SIZE});
+                                hs_uniform_sp_vec2_set(d->sp.p, d->sp.coord.view, dyn_view);
+                                hs_dyn_tilemap_draw(*d);
+                        } break;
+                        case SCENARIO_TILEMAP_FOG: {
+                                // the camera looks at -view, which is cam in tilemap space
+                                const vec2i viewer = hs_grid_cell(grid, cam);
+                                if (hs_fov_update(&fov, grid, viewer, FOV_RADIUS)) hs_fog_set_fov(&fog, fov);
+                                hs_fog_upload(&fog);
+                                hs_fog_activate(fog);
+                                hs_uniform_sp_vec2_set(fogged.sp.p, fogged.sp.coord.view, view);
+                                hs_tilemap_draw(fogged);
+                        } break;
+                        case SCENARIO_TILEMAP_LIGHTING:
+                                hs_uniform_sp_vec2_set(tilemaps[0].sp.p, tilemaps[0].sp.coord.view, view);
+                                hs_tilemap_draw(tilemaps[0]);
+                                hs_lighting_begin(&lighting);
+                                for (uint32_t i = 0; i < LIGHTS; i++) {
+                                        const vec2 offset = camera_path(frame + i * 13, frames, 1.0f + (i % 7) * 0.1f);
+                                        hs_lighting_push(&lighting, (hs_light){
+                                                .pos = {cam.x + offset.x, cam.y + offset.y * 2.0f},
+                                                .radius = LIGHT_RADIUS,
+                                                .r = (i & 1) ? 1.0f : 0.5f, .g = (i & 2) ? 1.0f : 0.5f, .b = (i & 4) ? 1.0f : 0.5f,
+                                        });
+                                }
+                                hs_uniform_sp_vec2_set(lighting.sp.p, lighting.sp.coord.view, view);
+                                hs_lighting_render(&lighting);
+                                hs_lighting_composite(lighting);
+                                break;
+                        case SCENARIO_PARTICLES:
+                                particles.emitter.pos = cam;
+                                hs_particles_update(&particles, 1.0f / 60.0f);
+                                hs_uniform_sp_vec2_set(particles.sp.p, particles.sp.coord.view, view);
+                                hs_particles_draw(particles);
+                                break;
+                        case SCENARIO_TEXT:
+                                hs_text_begin(&text);
+                                for (uint32_t i = 0; i < LABELS; i++) {
+                                        const vec2 pos = camera_path(frame + i * 7, frames, world_radius * (float)i / LABELS);
+                                        if (i & 1) {
+                                                hs_text_push_run(&text, name_tag, pos, 0.02f, (vec4){1.0f, 1.0f, 1.0f, 1.0f});
+                                        } else {
+                                                char damage[16];
+                                                snprintf(damage, sizeof(damage), "-%u", (frame * 31 + i) % 1000);
+                                                hs_text_push(&text, damage, pos, 0.03f, (vec4){1.0f, 0.2f, 0.2f, 1.0f});
+                                        }
+                                }
+                                hs_uniform_sp_vec2_set(text.sp.p, text.sp.coord.view, view);
+                                hs_text_draw(&text);
+                                break;
+                        case SCENARIO_SPRITES:
+                                hs_sp_use(sprite_sp);
+                                hs_uniform_vec2_set(sprite_sp.coord.view, view);
+                                for (uint32_t i = 0; i < sprites; i++) {
+                                        const vec2 pos = camera_path(frame + i * 7, frames, world_radius * random_float());
+                                        hs_uniform_vec2_set(sprite_sp.coord.model, pos);
+                                        hs_sprite_draw_current();
+                                }
+                                break;
+                        }
+
+                        glFinish();
+                        const uint64_t end = hs_bench_now_ns();
+                        hs_end_frame(gd);
+
+                        if (frame < WARMUP_FRAMES) continue;
+
+                        const hs_gl_stats gl_stats = hs_gl_stats_last_frame();
+                        samples[frame - WARMUP_FRAMES] = (end - start) / 1e6;
+                        draw_calls += gl_stats.draw_calls;
+                        state_changes += gl_stats.state_changes;
+                        vertices += gl_stats.vertices;
+                        upload_bytes += gl_stats.buffer_upload_bytes + gl_stats.texture_upload_bytes;
+                }
+
+                const hs_bench_summary summary = hs_bench_summarize(samples, frames);
+                printf("{\"bench\":\"render\",\"scenario\":\"%s\",\"map_size\":%u,\"layers\":%u,\"sprites\":%u,",
+                       scenario_names[scenario], size, LAYERS, scenario == SCENARIO_SPRITES ? sprites : 0);
+                hs_bench_summary_print_json(stdout, summary, "ms");
+                printf(",\"draw_calls\":%.1f,\"state_changes\":%.1f,\"vertices\":%.1f,\"upload_bytes\":%.1f}\n",
+                       (double)draw_calls / frames, (double)state_changes / frames,
+                       (double)vertices / frames, (double)upload_bytes / frames);
+        }
+
+        hs_text_run_free(&name_tag);
+        hs_text_free(&text);
+        hs_font_free(&font);
+        hs_particles_free(&particles);
+        hs_lighting_free(&lighting);
+        hs_tex_delete(occluders);
+        free(samples);
+        free(aroom.data);
+        hs_exit();
+        return 0;
+}
@@ -9,12 +9,14 @@
     #define _GLFW_WIN32
 #endif
 #if defined(__linux__)
-    #if !defined(_GLFW_WAYLAND)     // Required for Wayland windowing
+    #if !defined(_GLFW_WAYLAND) && !defined(_GLFW_OSMESA) // Required for Wayland windowing
         #define _GLFW_X11
     #endif
 #endif
 #if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || defined(__DragonFly__)
-    #define _GLFW_X11
+    #if !defined(_GLFW_OSMESA)
+        #define _GLFW_X11
+    #endif
 #endif
 #if defined(__APPLE__)
     #define _GLFW_COCOA
@@ -34,6 +36,17 @@
 #include "vulkan.c"
 #include "window.c"
 
+// Headless null platform, contexts are created through OSMesa
+#if defined(_GLFW_OSMESA)
+    #include "null_init.c"
+    #include "null_monitor.c"
+    #include "null_window.c"
+    #include "null_joystick.c"
+    #include "posix_time.c"
+    #include "posix_thread.c"
+    #include "osmesa_context.c"
+#else
+
 #if (defined _WIN32 | defined _WIN64)
     #include "win32_init.c"
     #include "win32_joystick.c"
@@ -95,6 +108,8 @@
     #include "osmesa_context.c"
 #endif
 
+#endif // _GLFW_OSMESA
+
 #endif // GLFW_IMPL
 
 #endif // __GLFW_IMPL_H__
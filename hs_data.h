@@ -126,6 +126,318 @@ static const char* texture_transform_frag =
         "FragColor = texture(u_tex, TexCoord);\n"
         "}";
 
+// texture_transform_vert for hs_tex_corner16, integer positions scaled by u_scale
+static const char* compact_transform_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in ivec2 aPos;\n"
+        "layout (location = 1) in vec2 aTexCoord;\n"
+        "out vec2 TexCoord;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "uniform vec2 u_scale;\n"
+        "void main()\n"
+        "{\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + vec2(aPos) * u_scale, 0.0, 1.0);\n"
+        "TexCoord = aTexCoord;\n"
+        "}";
+
+// texture_transform_vert with animated tiles, the tile is recovered from the tex coords
+// of the corner and swapped for the current frame from u_anim. the 0.001 crop that
+// hs_tex_square_set_tex puts on the y edges is undone first, so any tileset height works.
+// texel (tile, 0) is (frame count, total ms), texel (tile, 1 + f) is (frame tile, frame end ms)
+static const char* tile_anim_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 1) in vec2 aTexCoord;\n"
+        "out vec2 TexCoord;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "uniform usampler2D u_anim;\n"
+        "uniform vec2 u_tileset_size;\n"
+        "uniform uint u_time;\n"
+        "void main()\n"
+        "{\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + aPos, 0.0, 1.0);\n"
+        "TexCoord = aTexCoord;\n"
+        "int corner = gl_VertexID % 6;\n"
+        "vec2 far = vec2(corner >= 1 && corner <= 3, corner >= 2 && corner <= 4);\n"
+        "vec2 edge = aTexCoord + vec2(0.0, 0.001) * (far * 2.0 - 1.0);\n"
+        "vec2 cell = round(edge * u_tileset_size) - far;\n"
+        "int tile = int(cell.y * u_tileset_size.x + cell.x);\n"
+        "if (tile < 0 || tile >= textureSize(u_anim, 0).x) return;\n"
+        "uvec2 head = texelFetch(u_anim, ivec2(tile, 0), 0).rg;\n"
+        "if (head.x < 2u) return;\n"
+        "uint t = u_time % head.y;\n"
+        "uint frame_tile = 0u;\n"
+        "for (int f = 1; f <= int(head.x); f++) {\n"
+        "        uvec2 frame = texelFetch(u_anim, ivec2(tile, f), 0).rg;\n"
+        "        frame_tile = frame.x;\n"
+        "        if (t < frame.y) break;\n"
+        "}\n"
+        "uint columns = uint(u_tileset_size.x);\n"
+        "vec2 frame_cell = vec2(frame_tile % columns, frame_tile / columns);\n"
+        "TexCoord += (frame_cell - cell) / u_tileset_size;\n"
+        "}";
+
+// texture_transform_vert with the position in fog texture space, one fog texel per tile
+static const char* fog_transform_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 1) in vec2 aTexCoord;\n"
+        "out vec2 TexCoord;\n"
+        "out vec2 FogCoord;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "uniform vec2 u_fog_origin;\n"
+        "uniform vec2 u_fog_scale;\n"
+        "void main()\n"
+        "{\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + aPos, 0.0, 1.0);\n"
+        "TexCoord = aTexCoord;\n"
+        "FogCoord = (aPos - u_fog_origin) * u_fog_scale;\n"
+        "}";
+
+static const char* fog_transform_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 TexCoord;\n"
+        "in vec2 FogCoord;\n"
+        "uniform sampler2D u_tex;\n"
+        "uniform sampler2D u_fog;\n"
+        "void main()\n"
+        "{\n"
+        "FragColor = texture(u_tex, TexCoord);\n"
+        "FragColor.rgb *= texture(u_fog, FogCoord).r;\n"
+        "}";
+
+// every layer in one draw, tex.z picks the tileset in the texture array
+// and pos.z puts later layers in front when depth testing is on
+static const char* layered_tilemap_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in vec3 aTexCoord;\n"
+        "out vec3 TexCoord;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "void main()\n"
+        "{\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + aPos.xy, aPos.z, 1.0);\n"
+        "TexCoord = aTexCoord;\n"
+        "}";
+
+static const char* layered_tilemap_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec3 TexCoord;\n"
+        "uniform sampler2DArray u_tex;\n"
+        "void main()\n"
+        "{\n"
+        "vec4 color = texture(u_tex, TexCoord);\n"
+        "if (color.a == 0.0) discard;\n"
+        "FragColor = color;\n"
+        "}";
+
+// fullscreen triangle, no vertex buffer needed
+static const char* fullscreen_vert =
+        "#version 330 core\n"
+        "out vec2 TexCoord;\n"
+        "void main()\n"
+        "{\n"
+        "vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+        "TexCoord = pos;\n"
+        "gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);\n"
+        "}";
+
+// sharp bilinear, nearest inside texels and linear only across the texel edges
+// the source is the bottom left u_src_size texels of a u_tex_size texture
+static const char* sharp_bilinear_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 TexCoord;\n"
+        "uniform sampler2D u_tex;\n"
+        "uniform vec2 u_src_size;\n"
+        "uniform vec2 u_tex_size;\n"
+        "uniform vec2 u_scale;\n"
+        "void main()\n"
+        "{\n"
+        "vec2 texel = TexCoord * u_src_size;\n"
+        "vec2 region_range = max(0.5 - 0.5 / u_scale, vec2(0.0));\n"
+        "vec2 center_dist = fract(texel) - 0.5;\n"
+        "vec2 f = (center_dist - clamp(center_dist, -region_range, region_range)) * u_scale + 0.5;\n"
+        "vec2 mod_texel = clamp(floor(texel) + f, vec2(0.5), u_src_size - 0.5);\n"
+        "FragColor = texture(u_tex, mod_texel / u_tex_size);\n"
+        "}";
+
+// one instanced quad per hs_light, the corner comes from gl_VertexID
+static const char* light_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aLightPos;\n"
+        "layout (location = 1) in float aRadius;\n"
+        "layout (location = 2) in vec3 aColor;\n"
+        "out vec2 Offset;\n"
+        "out vec2 WorldPos;\n"
+        "out vec3 Color;\n"
+        "flat out vec2 LightPos;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "void main()\n"
+        "{\n"
+        "int id = gl_VertexID % 6;\n"
+        "Offset = vec2(id >= 1 && id <= 3 ? 1.0 : -1.0, id >= 2 && id <= 4 ? 1.0 : -1.0);\n"
+        "WorldPos = aLightPos + Offset * aRadius;\n"
+        "LightPos = aLightPos;\n"
+        "Color = aColor;\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + WorldPos, 0.0, 1.0);\n"
+        "}";
+
+// smooth falloff to zero at the radius, with u_occlusion set the segment to the light
+// is marched through the occluder texture at two samples per cell, skipping the
+// cell the fragment is in so walls are lit on the side facing the light
+static const char* light_frag =
+        "#version 330 core\n"
+        "#define MAX_STEPS 64\n"
+        "out vec4 FragColor;\n"
+        "in vec2 Offset;\n"
+        "in vec2 WorldPos;\n"
+        "in vec3 Color;\n"
+        "flat in vec2 LightPos;\n"
+        "uniform bool u_occlusion;\n"
+        "uniform sampler2D u_occluders;\n"
+        "uniform vec2 u_occ_origin;\n"
+        "uniform vec2 u_occ_scale;\n"
+        "uniform vec2 u_occ_size;\n"
+        "void main()\n"
+        "{\n"
+        "float d2 = dot(Offset, Offset);\n"
+        "if (d2 >= 1.0) discard;\n"
+        "float a = (1.0 - d2) * (1.0 - d2);\n"
+        "if (u_occlusion) {\n"
+        "        vec2 from = (WorldPos - u_occ_origin) * u_occ_scale;\n"
+        "        vec2 to = (LightPos - u_occ_origin) * u_occ_scale;\n"
+        "        vec2 cells = abs(to - from) * u_occ_size;\n"
+        "        int steps = min(int(max(cells.x, cells.y) * 2.0) + 1, MAX_STEPS);\n"
+        "        vec2 own = floor(from * u_occ_size);\n"
+        "        for (int i = 1; i < steps; i++) {\n"
+        "                vec2 p = mix(from, to, float(i) / float(steps));\n"
+        "                if (floor(p * u_occ_size) == own) continue;\n"
+        "                if (texture(u_occluders, p).r > 0.5) discard;\n"
+        "        }\n"
+        "}\n"
+        "FragColor = vec4(Color * a, 1.0);\n"
+        "}";
+
+// the light buffer multiplied into the scene, blended with GL_DST_COLOR, GL_ZERO
+static const char* light_composite_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 TexCoord;\n"
+        "uniform sampler2D u_tex;\n"
+        "void main()\n"
+        "{\n"
+        "FragColor = vec4(texture(u_tex, TexCoord).rgb, 1.0);\n"
+        "}";
+
+// one particle per vertex, captured with transform feedback into the other buffer.
+// a particle is waiting to be born while age < 0 and dead once age >= life,
+// dead ones are respawned around the emitter while u_emitting is set
+static const char* particle_update_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 1) in vec2 aVel;\n"
+        "layout (location = 2) in float aAge;\n"
+        "layout (location = 3) in float aLife;\n"
+        "out vec2 Pos;\n"
+        "out vec2 Vel;\n"
+        "out float Age;\n"
+        "out float Life;\n"
+        "uniform float u_dt;\n"
+        "uniform uint u_seed;\n"
+        "uniform bool u_emitting;\n"
+        "uniform vec2 u_emitter_pos;\n"
+        "uniform float u_radius;\n"
+        "uniform vec2 u_vel;\n"
+        "uniform float u_vel_spread;\n"
+        "uniform vec2 u_gravity;\n"
+        "uniform vec2 u_life;\n"
+        "uint state;\n"
+        "float rand()\n"
+        "{\n"
+        "state = state * 747796405u + 2891336453u;\n"
+        "uint w = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;\n"
+        "return float((w >> 22u) ^ w) / 4294967296.0;\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "Pos = aPos;\n"
+        "Vel = aVel;\n"
+        "Age = aAge + u_dt;\n"
+        "Life = aLife;\n"
+        "if (Age >= Life && Age >= 0.0) {\n"
+        "        if (!u_emitting) return;\n"
+        "        state = uint(gl_VertexID) * 2654435769u ^ u_seed;\n"
+        "        float a = rand() * 6.2831853;\n"
+        "        Pos = u_emitter_pos + vec2(cos(a), sin(a)) * sqrt(rand()) * u_radius;\n"
+        "        a = rand() * 6.2831853;\n"
+        "        Vel = u_vel + vec2(cos(a), sin(a)) * rand() * u_vel_spread;\n"
+        "        Life = mix(u_life.x, u_life.y, rand());\n"
+        "        Age = 0.0;\n"
+        "} else if (Age > 0.0) {\n"
+        "        Vel += u_gravity * u_dt;\n"
+        "        Pos += Vel * u_dt;\n"
+        "}\n"
+        "}";
+
+// one instanced quad per particle, size, color and atlas tile follow the age
+static const char* particle_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 2) in float aAge;\n"
+        "layout (location = 3) in float aLife;\n"
+        "out vec2 TexCoord;\n"
+        "out vec4 Color;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "uniform vec2 u_size;\n"
+        "uniform vec4 u_color_start;\n"
+        "uniform vec4 u_color_end;\n"
+        "uniform vec2 u_tileset_size;\n"
+        "uniform uint u_tile;\n"
+        "uniform uint u_frames;\n"
+        "void main()\n"
+        "{\n"
+        "if (aAge < 0.0 || aAge >= aLife) {\n"
+        "        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+        "        return;\n"
+        "}\n"
+        "float t = aAge / aLife;\n"
+        "int corner = gl_VertexID % 6;\n"
+        "vec2 far = vec2(corner >= 1 && corner <= 3, corner >= 2 && corner <= 4);\n"
+        "vec2 pos = aPos + (far * 2.0 - 1.0) * mix(u_size.x, u_size.y, t);\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + pos, 0.0, 1.0);\n"
+        "uint tile = u_tile + min(uint(t * float(u_frames)), u_frames - 1u);\n"
+        "uint columns = uint(u_tileset_size.x);\n"
+        "TexCoord = (vec2(tile % columns, tile / columns) + far) / u_tileset_size;\n"
+        "Color = mix(u_color_start, u_color_end, t);\n"
+        "}";
+
+static const char* particle_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 TexCoord;\n"
+        "in vec4 Color;\n"
+        "uniform sampler2D u_tex;\n"
+        "void main()\n"
+        "{\n"
+        "FragColor = texture(u_tex, TexCoord) * Color;\n"
+        "if (FragColor.a == 0.0) discard;\n"
+        "}";
+
 // default missing texture
 // size is 32*32 RGBA
 const unsigned char hs_default_missing_tex_data[] =
@@ -0,0 +1,596 @@
+#ifndef HS_GL_STATS_H_
+#include "hs_graphics.h"
+
+// Opt-in GL call accounting, define HS_GL_STATS before including hs_graphics.h.
+// hs_init swaps the glad function pointers for counting wrappers,
+// so everything going through glad is counted, including nuklear.
+
+enum hs_gl_call {
+        HS_GL_DRAW_ARRAYS,
+        HS_GL_DRAW_ARRAYS_INSTANCED,
+        HS_GL_DRAW_ELEMENTS,
+        HS_GL_BUFFER_DATA,
+        HS_GL_BUFFER_SUB_DATA,
+        HS_GL_BUFFER_STORAGE,
+        HS_GL_TEX_IMAGE_2D,
+        HS_GL_TEX_SUB_IMAGE_2D,
+        HS_GL_TEX_IMAGE_3D,
+        HS_GL_GENERATE_MIPMAP,
+        HS_GL_BIND_BUFFER,
+        HS_GL_BIND_TEXTURE,
+        HS_GL_ACTIVE_TEXTURE,
+        HS_GL_BIND_VERTEX_ARRAY,
+        HS_GL_BIND_FRAMEBUFFER,
+        HS_GL_USE_PROGRAM,
+        HS_GL_UNIFORM,
+        HS_GL_DELETE_BUFFERS,
+        HS_GL_DELETE_TEXTURES,
+        HS_GL_DELETE_VERTEX_ARRAYS,
+        HS_GL_CALL_COUNT,
+};
+
+typedef struct {
+        uint32_t calls[HS_GL_CALL_COUNT];
+        uint32_t draw_calls, state_changes;
+        uint64_t vertices;
+        uint64_t buffer_upload_bytes, texture_upload_bytes;
+        uint64_t buffer_live_bytes, texture_live_bytes; // total
+} hs_gl_stats;
+
+typedef struct {
+        uint64_t live_bytes, frame_upload_bytes, total_upload_bytes;
+} hs_gl_object_stats;
+
+extern void               hs_gl_stats_hook();
+extern void               hs_gl_stats_frame_end();
+extern hs_gl_stats        hs_gl_stats_get();
+extern hs_gl_stats        hs_gl_stats_last_frame();
+extern hs_gl_object_stats hs_gl_stats_buffer(const uint32_t buffer);
+extern hs_gl_object_stats hs_gl_stats_texture(const uint32_t tex);
+extern void               hs_gl_stats_buffer_write(const uint32_t buffer, const uint64_t bytes);
+extern const char*        hs_gl_call_name(const enum hs_gl_call call);
+
+#ifdef HS_IMPL
+#define HS_GL_STATS_IMPL
+#endif //HS_IMPL
+
+#ifdef HS_GL_STATS_IMPL
+
+#define HS_GL_STATS_TEXTURE_UNITS 32
+// 2D, 2D array, 3D and one slot shared by cube maps and the rest
+#define HS_GL_STATS_TEXTURE_TARGETS 4
+
+static hs_gl_stats hs_gl_stats_curr = {0};
+static hs_gl_stats hs_gl_stats_last = {0};
+
+// indexed by GL object name
+static hs_dynarr hs_gl_stats_buffers = {0};
+static hs_dynarr hs_gl_stats_textures = {0};
+
+static uint32_t hs_gl_bound_array_buffer = 0;
+static uint32_t hs_gl_bound_other_buffer = 0;
+static uint32_t hs_gl_bound_vertex_array = 0;
+// uint32_t indexed by vertex array name, the element array binding is vertex array state
+static hs_dynarr hs_gl_vao_element_buffers = {0};
+static uint32_t hs_gl_active_texture = 0;
+static uint32_t hs_gl_bound_textures[HS_GL_STATS_TEXTURE_UNITS][HS_GL_STATS_TEXTURE_TARGETS] = {0};
+
+static PFNGLDRAWARRAYSPROC          hs_gl_real_DrawArrays;
+static PFNGLDRAWARRAYSINSTANCEDPROC hs_gl_real_DrawArraysInstanced;
+static PFNGLDRAWELEMENTSPROC        hs_gl_real_DrawElements;
+static PFNGLBUFFERDATAPROC          hs_gl_real_BufferData;
+static PFNGLBUFFERSUBDATAPROC       hs_gl_real_BufferSubData;
+static PFNGLBUFFERSTORAGEPROC       hs_gl_real_BufferStorage;
+static PFNGLTEXIMAGE2DPROC          hs_gl_real_TexImage2D;
+static PFNGLTEXSUBIMAGE2DPROC       hs_gl_real_TexSubImage2D;
+static PFNGLTEXIMAGE3DPROC          hs_gl_real_TexImage3D;
+static PFNGLGENERATEMIPMAPPROC      hs_gl_real_GenerateMipmap;
+static PFNGLBINDBUFFERPROC          hs_gl_real_BindBuffer;
+static PFNGLBINDTEXTUREPROC         hs_gl_real_BindTexture;
+static PFNGLACTIVETEXTUREPROC       hs_gl_real_ActiveTexture;
+static PFNGLBINDVERTEXARRAYPROC     hs_gl_real_BindVertexArray;
+static PFNGLBINDFRAMEBUFFERPROC     hs_gl_real_BindFramebuffer;
+static PFNGLUSEPROGRAMPROC          hs_gl_real_UseProgram;
+static PFNGLUNIFORM1IPROC           hs_gl_real_Uniform1i;
+static PFNGLUNIFORM1FPROC           hs_gl_real_Uniform1f;
+static PFNGLUNIFORM1UIPROC          hs_gl_real_Uniform1ui;
+static PFNGLUNIFORM2FVPROC          hs_gl_real_Uniform2fv;
+static PFNGLUNIFORMMATRIX4FVPROC    hs_gl_real_UniformMatrix4fv;
+static PFNGLDELETEBUFFERSPROC       hs_gl_real_DeleteBuffers;
+static PFNGLDELETETEXTURESPROC      hs_gl_real_DeleteTextures;
+static PFNGLDELETEVERTEXARRAYSPROC  hs_gl_real_DeleteVertexArrays;
+
+static const char* hs_gl_call_names[HS_GL_CALL_COUNT] = {
+        [HS_GL_DRAW_ARRAYS]           = "glDrawArrays",
+        [HS_GL_DRAW_ARRAYS_INSTANCED] = "glDrawArraysInstanced",
+        [HS_GL_DRAW_ELEMENTS]         = "glDrawElements",
+        [HS_GL_BUFFER_DATA]           = "glBufferData",
+        [HS_GL_BUFFER_SUB_DATA]       = "glBufferSubData",
+        [HS_GL_BUFFER_STORAGE]        = "glBufferStorage",
+        [HS_GL_TEX_IMAGE_2D]          = "glTexImage2D",
+        [HS_GL_TEX_SUB_IMAGE_2D]      = "glTexSubImage2D",
+        [HS_GL_TEX_IMAGE_3D]          = "glTexImage3D",
+        [HS_GL_GENERATE_MIPMAP]       = "glGenerateMipmap",
+        [HS_GL_BIND_BUFFER]           = "glBindBuffer",
+        [HS_GL_BIND_TEXTURE]          = "glBindTexture",
+        [HS_GL_ACTIVE_TEXTURE]        = "glActiveTexture",
+        [HS_GL_BIND_VERTEX_ARRAY]     = "glBindVertexArray",
+        [HS_GL_BIND_FRAMEBUFFER]      = "glBindFramebuffer",
+        [HS_GL_USE_PROGRAM]           = "glUseProgram",
+        [HS_GL_UNIFORM]               = "glUniform*",
+        [HS_GL_DELETE_BUFFERS]        = "glDeleteBuffers",
+        [HS_GL_DELETE_TEXTURES]       = "glDeleteTextures",
+        [HS_GL_DELETE_VERTEX_ARRAYS]  = "glDeleteVertexArrays",
+};
+
+inline const char*
+hs_gl_call_name(const enum hs_gl_call call)
+{
+        return hs_gl_call_names[call];
+}
+
+static hs_gl_object_stats*
+hs_gl_stats_object(hs_dynarr* objects, const uint32_t name)
+{
+        if (!objects->data) {
+                *objects = hs_dynarr_init(hs_gl_object_stats, 64);
+                hs_dynarr_zero((*objects), hs_gl_object_stats);
+        }
+        if (name >= objects->cap) {
+                const size_t old_cap = objects->cap;
+                size_t new_cap = old_cap;
+                while (name >= new_cap) new_cap *= 2;
+                hs_dynarr_resize((*objects), hs_gl_object_stats, new_cap);
+                memset(hs_dynarr_data((*objects), hs_gl_object_stats) + old_cap, 0,
+                       (new_cap - old_cap) * sizeof(hs_gl_object_stats));
+        }
+        if (name >= objects->len) objects->len = name + 1;
+        return &hs_dynarr_idx((*objects), hs_gl_object_stats, name);
+}
+
+static uint32_t*
+hs_gl_stats_element_buffer(const uint32_t vao)
+{
+        if (!hs_gl_vao_element_buffers.data) {
+                hs_gl_vao_element_buffers = hs_dynarr_init(uint32_t, 64);
+                hs_dynarr_zero(hs_gl_vao_element_buffers, uint32_t);
+        }
+        if (vao >= hs_gl_vao_element_buffers.cap) {
+                const size_t old_cap = hs_gl_vao_element_buffers.cap;
+                size_t new_cap = old_cap;
+                while (vao >= new_cap) new_cap *= 2;
+                hs_dynarr_resize(hs_gl_vao_element_buffers, uint32_t, new_cap);
+                memset(hs_dynarr_data(hs_gl_vao_element_buffers, uint32_t) + old_cap, 0,
+                       (new_cap - old_cap) * sizeof(uint32_t));
+        }
+        return &hs_dynarr_idx(hs_gl_vao_element_buffers, uint32_t, vao);
+}
+
+static uint32_t*
+hs_gl_stats_bound_buffer(const GLenum target)
+{
+        switch (target) {
+        case GL_ARRAY_BUFFER:         return &hs_gl_bound_array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return hs_gl_stats_element_buffer(hs_gl_bound_vertex_array);
+        default:                      return &hs_gl_bound_other_buffer;
+        }
+}
+
+// the binding of the active unit for target, cube map faces go to the cube map
+static uint32_t*
+hs_gl_stats_bound_texture(const GLenum target)
+{
+        uint32_t slot;
+        switch (target) {
+        case GL_TEXTURE_2D:       slot = 0; break;
+        case GL_TEXTURE_2D_ARRAY: slot = 1; break;
+        case GL_TEXTURE_3D:       slot = 2; break;
+        default:                  slot = 3; break;
+        }
+        return &hs_gl_bound_textures[hs_gl_active_texture][slot];
+}
+
+static uint32_t
+hs_gl_pixel_size(const GLenum format, const GLenum type)
+{
+        uint32_t channels;
+        switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: channels = 1; break;
+        case GL_RG:  case GL_RG_INTEGER:                          channels = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER:            channels = 3; break;
+        default:                                                  channels = 4; break;
+        }
+
+        switch (type) {
+        case GL_UNSIGNED_BYTE: case GL_BYTE:                      return channels;
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return channels * 2;
+        default:                                                  return channels * 4;
+        }
+}
+
+static void APIENTRY
+hs_gl_hook_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+        hs_gl_stats_curr.calls[HS_GL_DRAW_ARRAYS]++;
+        hs_gl_stats_curr.draw_calls++;
+        hs_gl_stats_curr.vertices += count;
+        hs_gl_real_DrawArrays(mode, first, count);
+}
+
+static void APIENTRY
+hs_gl_hook_DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+        hs_gl_stats_curr.calls[HS_GL_DRAW_ARRAYS_INSTANCED]++;
+        hs_gl_stats_curr.draw_calls++;
+        hs_gl_stats_curr.vertices += (uint64_t)count * instancecount;
+        hs_gl_real_DrawArraysInstanced(mode, first, count, instancecount);
+}
+
+static void APIENTRY
+hs_gl_hook_DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+        hs_gl_stats_curr.calls[HS_GL_DRAW_ELEMENTS]++;
+        hs_gl_stats_curr.draw_calls++;
+        hs_gl_stats_curr.vertices += count;
+        hs_gl_real_DrawElements(mode, count, type, indices);
+}
+
+static void APIENTRY
+hs_gl_hook_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+        hs_gl_stats_curr.calls[HS_GL_BUFFER_DATA]++;
+        hs_gl_object_stats* buf = hs_gl_stats_object(&hs_gl_stats_buffers, *hs_gl_stats_bound_buffer(target));
+
+        hs_gl_stats_curr.buffer_live_bytes -= buf->live_bytes;
+        hs_gl_stats_curr.buffer_live_bytes += size;
+        buf->live_bytes = size;
+
+        if (data) {
+                hs_gl_stats_curr.buffer_upload_bytes += size;
+                buf->frame_upload_bytes += size;
+                buf->total_upload_bytes += size;
+        }
+        hs_gl_real_BufferData(target, size, data, usage);
+}
+
+// immutable storage like the persistent stream buffers, counted like glBufferData
+static void APIENTRY
+hs_gl_hook_BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+        hs_gl_stats_curr.calls[HS_GL_BUFFER_STORAGE]++;
+        hs_gl_object_stats* buf = hs_gl_stats_object(&hs_gl_stats_buffers, *hs_gl_stats_bound_buffer(target));
+
+        hs_gl_stats_curr.buffer_live_bytes -= buf->live_bytes;
+        hs_gl_stats_curr.buffer_live_bytes += size;
+        buf->live_bytes = size;
+
+        if (data) {
+                hs_gl_stats_curr.buffer_upload_bytes += size;
+                buf->frame_upload_bytes += size;
+                buf->total_upload_bytes += size;
+        }
+        hs_gl_real_BufferStorage(target, size, data, flags);
+}
+
+static void APIENTRY
+hs_gl_hook_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+        hs_gl_stats_curr.calls[HS_GL_BUFFER_SUB_DATA]++;
+        hs_gl_object_stats* buf = hs_gl_stats_object(&hs_gl_stats_buffers, *hs_gl_stats_bound_buffer(target));
+
+        hs_gl_stats_curr.buffer_upload_bytes += size;
+        buf->frame_upload_bytes += size;
+        buf->total_upload_bytes += size;
+        hs_gl_real_BufferSubData(target, offset, size, data);
+}
+
+static void APIENTRY
+hs_gl_hook_TexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                      GLint border, GLenum format, GLenum type, const void* pixels)
+{
+        hs_gl_stats_curr.calls[HS_GL_TEX_IMAGE_2D]++;
+        hs_gl_object_stats* tex = hs_gl_stats_object(&hs_gl_stats_textures,
+                                                     *hs_gl_stats_bound_texture(target));
+        const uint64_t size = (uint64_t)width * height * hs_gl_pixel_size(format, type);
+
+        // only track the base level, mipmaps are added by glGenerateMipmap
+        if (level == 0) {
+                hs_gl_stats_curr.texture_live_bytes -= tex->live_bytes;
+                hs_gl_stats_curr.texture_live_bytes += size;
+                tex->live_bytes = size;
+        }
+
+        if (pixels) {
+                hs_gl_stats_curr.texture_upload_bytes += size;
+                tex->frame_upload_bytes += size;
+                tex->total_upload_bytes += size;
+        }
+        hs_gl_real_TexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+static void APIENTRY
+hs_gl_hook_TexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                         GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+        hs_gl_stats_curr.calls[HS_GL_TEX_SUB_IMAGE_2D]++;
+        hs_gl_object_stats* tex = hs_gl_stats_object(&hs_gl_stats_textures,
+                                                     *hs_gl_stats_bound_texture(target));
+        const uint64_t size = (uint64_t)width * height * hs_gl_pixel_size(format, type);
+
+        hs_gl_stats_curr.texture_upload_bytes += size;
+        tex->frame_upload_bytes += size;
+        tex->total_upload_bytes += size;
+        hs_gl_real_TexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+static void APIENTRY
+hs_gl_hook_TexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                      GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+        hs_gl_stats_curr.calls[HS_GL_TEX_IMAGE_3D]++;
+        hs_gl_object_stats* tex = hs_gl_stats_object(&hs_gl_stats_textures,
+                                                     *hs_gl_stats_bound_texture(target));
+        const uint64_t size = (uint64_t)width * height * depth * hs_gl_pixel_size(format, type);
+
+        if (level == 0) {
+                hs_gl_stats_curr.texture_live_bytes -= tex->live_bytes;
+                hs_gl_stats_curr.texture_live_bytes += size;
+                tex->live_bytes = size;
+        }
+
+        if (pixels) {
+                hs_gl_stats_curr.texture_upload_bytes += size;
+                tex->frame_upload_bytes += size;
+                tex->total_upload_bytes += size;
+        }
+        hs_gl_real_TexImage3D(target, level, internalformat, width, height, depth, border, format, type, pixels);
+}
+
+static void APIENTRY
+hs_gl_hook_GenerateMipmap(GLenum target)
+{
+        hs_gl_stats_curr.calls[HS_GL_GENERATE_MIPMAP]++;
+        hs_gl_object_stats* tex = hs_gl_stats_object(&hs_gl_stats_textures,
+                                                     *hs_gl_stats_bound_texture(target));
+
+        // the full mip chain is about a third of the base level
+        const uint64_t size = tex->live_bytes + tex->live_bytes / 3;
+        hs_gl_stats_curr.texture_live_bytes += size - tex->live_bytes;
+        tex->live_bytes = size;
+        hs_gl_real_GenerateMipmap(target);
+}
+
+static void APIENTRY
+hs_gl_hook_BindBuffer(GLenum target, GLuint buffer)
+{
+        hs_gl_stats_curr.calls[HS_GL_BIND_BUFFER]++;
+        hs_gl_stats_curr.state_changes++;
+        *hs_gl_stats_bound_buffer(target) = buffer;
+        hs_gl_real_BindBuffer(target, buffer);
+}
+
+static void APIENTRY
+hs_gl_hook_BindTexture(GLenum target, GLuint texture)
+{
+        hs_gl_stats_curr.calls[HS_GL_BIND_TEXTURE]++;
+        hs_gl_stats_curr.state_changes++;
+        *hs_gl_stats_bound_texture(target) = texture;
+        hs_gl_real_BindTexture(target, texture);
+}
+
+static void APIENTRY
+hs_gl_hook_ActiveTexture(GLenum texture)
+{
+        hs_gl_stats_curr.calls[HS_GL_ACTIVE_TEXTURE]++;
+        hs_gl_stats_curr.state_changes++;
+        hs_gl_active_texture = (texture - GL_TEXTURE0) % HS_GL_STATS_TEXTURE_UNITS;
+        hs_gl_real_ActiveTexture(texture);
+}
+
+static void APIENTRY
+hs_gl_hook_BindVertexArray(GLuint array)
+{
+        hs_gl_stats_curr.calls[HS_GL_BIND_VERTEX_ARRAY]++;
+        hs_gl_stats_curr.state_changes++;
+        // brings its own element array binding along
+        hs_gl_bound_vertex_array = array;
+        hs_gl_real_BindVertexArray(array);
+}
+
+static void APIENTRY
+hs_gl_hook_BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+        hs_gl_stats_curr.calls[HS_GL_BIND_FRAMEBUFFER]++;
+        hs_gl_stats_curr.state_changes++;
+        hs_gl_real_BindFramebuffer(target, framebuffer);
+}
+
+static void APIENTRY
+hs_gl_hook_UseProgram(GLuint program)
+{
+        hs_gl_stats_curr.calls[HS_GL_USE_PROGRAM]++;
+        hs_gl_stats_curr.state_changes++;
+        hs_gl_real_UseProgram(program);
+}
+
+static void APIENTRY
+hs_gl_hook_Uniform1i(GLint location, GLint v0)
+{
+        hs_gl_stats_curr.calls[HS_GL_UNIFORM]++;
+        hs_gl_real_Uniform1i(location, v0);
+}
+
+static void APIENTRY
+hs_gl_hook_Uniform1f(GLint location, GLfloat v0)
+{
+        hs_gl_stats_curr.calls[HS_GL_UNIFORM]++;
+        hs_gl_real_Uniform1f(location, v0);
+}
+
+static void APIENTRY
+hs_gl_hook_Uniform1ui(GLint location, GLuint v0)
+{
+        hs_gl_stats_curr.calls[HS_GL_UNIFORM]++;
+        hs_gl_real_Uniform1ui(location, v0);
+}
+
+static void APIENTRY
+hs_gl_hook_Uniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+        hs_gl_stats_curr.calls[HS_GL_UNIFORM]++;
+        hs_gl_real_Uniform2fv(location, count, value);
+}
+
+static void APIENTRY
+hs_gl_hook_UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+        hs_gl_stats_curr.calls[HS_GL_UNIFORM]++;
+        hs_gl_real_UniformMatrix4fv(location, count, transpose, value);
+}
+
+static void APIENTRY
+hs_gl_hook_DeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+        hs_gl_stats_curr.calls[HS_GL_DELETE_BUFFERS]++;
+        for (GLsizei i = 0; i < n; i++) {
+                if (!buffers[i]) continue;
+                hs_gl_object_stats* buf = hs_gl_stats_object(&hs_gl_stats_buffers, buffers[i]);
+                hs_gl_stats_curr.buffer_live_bytes -= buf->live_bytes;
+                *buf = (hs_gl_object_stats){0};
+
+                // deleting unbinds it from the context and the bound vertex array only
+                uint32_t* element_buffer = hs_gl_stats_element_buffer(hs_gl_bound_vertex_array);
+                if (*element_buffer == buffers[i]) *element_buffer = 0;
+                if (hs_gl_bound_array_buffer == buffers[i]) hs_gl_bound_array_buffer = 0;
+                if (hs_gl_bound_other_buffer == buffers[i]) hs_gl_bound_other_buffer = 0;
+        }
+        hs_gl_real_DeleteBuffers(n, buffers);
+}
+
+static void APIENTRY
+hs_gl_hook_DeleteTextures(GLsizei n, const GLuint* textures)
+{
+        hs_gl_stats_curr.calls[HS_GL_DELETE_TEXTURES]++;
+        for (GLsizei i = 0; i < n; i++) {
+                if (!textures[i]) continue;
+                hs_gl_object_stats* tex = hs_gl_stats_object(&hs_gl_stats_textures, textures[i]);
+                hs_gl_stats_curr.texture_live_bytes -= tex->live_bytes;
+                *tex = (hs_gl_object_stats){0};
+        }
+        hs_gl_real_DeleteTextures(n, textures);
+}
+
+static void APIENTRY
+hs_gl_hook_DeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+        hs_gl_stats_curr.calls[HS_GL_DELETE_VERTEX_ARRAYS]++;
+        // the names get reused, a new vertex array starts without an element buffer
+        for (GLsizei i = 0; i < n; i++) {
+                if (!arrays[i]) continue;
+                *hs_gl_stats_element_buffer(arrays[i]) = 0;
+                if (hs_gl_bound_vertex_array == arrays[i]) hs_gl_bound_vertex_array = 0;
+        }
+        hs_gl_real_DeleteVertexArrays(n, arrays);
+}
+
+#define HS_GL_HOOK(_name)                               \
+        hs_gl_real_##_name = glad_gl##_name;            \
+        glad_gl##_name = hs_gl_hook_##_name
+
+void
+hs_gl_stats_hook()
+{
+        // hooking twice would make the hooks call themselves
+        static uint32_t hooked = false;
+        if (hooked) return;
+        hooked = true;
+
+        HS_GL_HOOK(DrawArrays);
+        HS_GL_HOOK(DrawArraysInstanced);
+        HS_GL_HOOK(DrawElements);
+        HS_GL_HOOK(BufferData);
+        HS_GL_HOOK(BufferSubData);
+        // only loaded on 4.4 contexts
+        if (GLAD_GL_VERSION_4_4) {
+                HS_GL_HOOK(BufferStorage);
+        }
+        HS_GL_HOOK(TexImage2D);
+        HS_GL_HOOK(TexSubImage2D);
+        HS_GL_HOOK(TexImage3D);
+        HS_GL_HOOK(GenerateMipmap);
+        HS_GL_HOOK(BindBuffer);
+        HS_GL_HOOK(BindTexture);
+        HS_GL_HOOK(ActiveTexture);
+        HS_GL_HOOK(BindVertexArray);
+        HS_GL_HOOK(BindFramebuffer);
+        HS_GL_HOOK(UseProgram);
+        HS_GL_HOOK(Uniform1i);
+        HS_GL_HOOK(Uniform1f);
+        HS_GL_HOOK(Uniform1ui);
+        HS_GL_HOOK(Uniform2fv);
+        HS_GL_HOOK(UniformMatrix4fv);
+        HS_GL_HOOK(DeleteBuffers);
+        HS_GL_HOOK(DeleteTextures);
+        HS_GL_HOOK(DeleteVertexArrays);
+}
+
+#undef HS_GL_HOOK
+
+void
+hs_gl_stats_frame_end()
+{
+        hs_gl_stats_last = hs_gl_stats_curr;
+
+        memset(hs_gl_stats_curr.calls, 0, sizeof(hs_gl_stats_curr.calls));
+        hs_gl_stats_curr.draw_calls = 0;
+        hs_gl_stats_curr.state_changes = 0;
+        hs_gl_stats_curr.vertices = 0;
+        hs_gl_stats_curr.buffer_upload_bytes = 0;
+        hs_gl_stats_curr.texture_upload_bytes = 0;
+
+        for (size_t i = 0; i < hs_gl_stats_buffers.len; i++)
+                hs_dynarr_idx(hs_gl_stats_buffers, hs_gl_object_stats, i).frame_upload_bytes = 0;
+        for (size_t i = 0; i < hs_gl_stats_textures.len; i++)
+                hs_dynarr_idx(hs_gl_stats_textures, hs_gl_object_stats, i).frame_upload_bytes = 0;
+}
+
+inline hs_gl_stats
+hs_gl_stats_get()
+{
+        return hs_gl_stats_curr;
+}
+
+inline hs_gl_stats
+hs_gl_stats_last_frame()
+{
+        return hs_gl_stats_last;
+}
+
+inline hs_gl_object_stats
+hs_gl_stats_buffer(const uint32_t buffer)
+{
+        if (buffer >= hs_gl_stats_buffers.len) return (hs_gl_object_stats){0};
+        return hs_dynarr_idx(hs_gl_stats_buffers, hs_gl_object_stats, buffer);
+}
+
+// writes through mapped pointers never reach a gl call, hs_stream_buffer reports them here
+inline void
+hs_gl_stats_buffer_write(const uint32_t buffer, const uint64_t bytes)
+{
+        hs_gl_object_stats* buf = hs_gl_stats_object(&hs_gl_stats_buffers, buffer);
+        hs_gl_stats_curr.buffer_upload_bytes += bytes;
+        buf->frame_upload_bytes += bytes;
+        buf->total_upload_bytes += bytes;
+}
+
+inline hs_gl_object_stats
+hs_gl_stats_texture(const uint32_t tex)
+{
+        if (tex >= hs_gl_stats_textures.len) return (hs_gl_object_stats){0};
+        return hs_dynarr_idx(hs_gl_stats_textures, hs_gl_object_stats, tex);
+}
+
+#endif // HS_GL_STATS_IMPL
+
+#define HS_GL_STATS_H_
+#endif // HS_GL_STATS_H_
@@ -5,12 +5,22 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
 #ifdef WIN32
 #define OEMRESOURCE
 #include <windows.h>
+#include <mmsystem.h> // timeBeginPeriod, link winmm
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")
+#endif
+// missing from older sdk and mingw headers
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 #endif
 
 #include "hs_math.h"
@@ -31,10 +41,6 @@
 #include "external/sfd/src/sfd.c"
 #endif
 
-#ifdef HS_NUKLEAR
-#include "hs_nuklear.h"
-#endif
-
 #define hs_key_init(glfw_key) &(hs_key){.key = glfw_key}
 
 typedef struct {
@@ -71,6 +77,16 @@ typedef struct {
          hs_tex_corner c[6];
 } hs_tex_square;
 
+// half the size of hs_tex_corner, pos is in units of u_scale and tex is normalized
+typedef struct {
+        int16_t pos[2];
+        uint16_t tex[2];
+} hs_tex_corner16;
+
+typedef struct {
+         hs_tex_corner16 c[6];
+} hs_tex_square16;
+
 typedef struct {
         uint32_t width, height, tileset_width, tileset_height;
         float tile_width, tile_height;
@@ -79,12 +95,58 @@ typedef struct {
         hs_tex_square* vertices;
 } hs_tilemap;
 
+// vec3 is padded to 16 bytes, keep the corner at 6 floats
+typedef struct {
+        vec2 pos;
+        float depth;
+        vec2 tex;
+        float slice; // texture array layer
+} hs_tex_layer_corner;
+
+typedef struct {
+         hs_tex_layer_corner c[6];
+} hs_tex_layer_square;
+
+#define HS_LAYERED_TILEMAP_MAX_LAYERS 8
+
+// every layer of an aroom in one buffer and one draw call, layers are stored
+// bottom first so blending keeps them in order, tilesets are texture array slices
+typedef struct {
+        uint32_t width, height, layers, tileset_width, tileset_height;
+        float tile_width, tile_height;
+        uint32_t tileset[HS_LAYERED_TILEMAP_MAX_LAYERS]; // texture array slice per layer
+        bool skip_empty;       // tile 0 above the first layer is not drawn
+        uint32_t square_count; // squares in use after skipping
+        hs_shader_program sp;
+        hs_tex tex;            // GL_TEXTURE_2D_ARRAY
+        hs_tex_layer_square* vertices;
+} hs_layered_tilemap;
+
+#define HS_STREAM_FRAMES 3
+
+// vertex buffer split in HS_STREAM_FRAMES sections written by the cpu while the gpu
+// reads the others, a fence per section keeps them apart. persistently mapped on
+// GL 4.4, otherwise every write maps its range unsynchronized
+typedef struct {
+        uint32_t vbo;
+        uint32_t size, stride;  // bytes per section, writes start at a multiple of stride
+        uint32_t frame, offset; // section in use and the write position inside it
+        uint32_t begin;         // buffer offset of the open write
+        uint32_t first;         // first vertex of the last write, for glDrawArrays
+        uint8_t* mapped;        // whole buffer when persistent
+        uint8_t* write;         // open write, NULL when closed
+        bool persistent;
+        GLsync fences[HS_STREAM_FRAMES];
+} hs_stream_buffer;
+
 typedef struct {
         uint32_t tileset_width, tileset_height;
         float tile_width, tile_height;
         hs_shader_program sp;
         hs_tex tex;
-        hs_dynarr vertices;
+        hs_dynarr vertices;       // only len and cap are used when streaming
+        hs_stream_buffer* stream; // set by hs_dyn_tilemap_init_stream
+        bool compact;             // hs_tex_square16 vertices, positions within +-16383 tiles
 } hs_dyn_tilemap;
 
 // this is how anders tale rooms are stored
@@ -94,11 +156,160 @@ typedef struct {
         uint8_t* data;
 } hs_aroom;
 
+// tex coords of all 256 aroom tiles for one tileset size, built once instead of per tile
+typedef struct {
+        uint32_t tileset_width, tileset_height;
+        vec2 tiles[256][6];
+} hs_tileset_uv;
+
+#define HS_TILE_ANIM_MAX_FRAMES 16
+
+// a tile that cycles through other tiles of the same tileset
+typedef struct {
+        uint16_t tile;       // the tile as placed in the map
+        uint16_t frame_count;
+        uint16_t frames[HS_TILE_ANIM_MAX_FRAMES];   // tile shown for each frame
+        uint16_t frame_ms[HS_TILE_ANIM_MAX_FRAMES]; // duration of each frame
+} hs_tile_anim;
+
+// animations of a tileset as an integer texture, read by tile_anim_vert
+typedef struct {
+        uint32_t tex;
+        uint32_t tileset_width, tileset_height;
+} hs_tile_anim_table;
+
 typedef struct {
         uint32_t width, height;
         GLFWwindow* window;
 } hs_game_data;
 
+// simulation runs in fixed ticks, rendering interpolates between the last two with alpha
+typedef struct {
+        float tick;        // ms per simulation tick
+        float accumulator; // ms not yet simulated
+        float alpha;       // [0, 1) into the next tick
+        uint32_t max_ticks; // ticks per frame before dropping time
+} hs_fixed_step;
+
+#define HS_FIXED_STEP_INIT(tick_rate) {.tick = 1000.0f / (tick_rate), .max_ticks = 8}
+
+// sleeps until shortly before the deadline and busy waits the rest
+typedef struct {
+        uint64_t frame_ns;   // target frame duration
+        uint64_t spin_ns;    // final slice before the deadline that is busy waited
+        uint64_t deadline;
+        uint64_t input_ns;   // when input was polled this frame
+        uint64_t latency_ns; // input to present of the last frame
+        uint32_t measure_latency; // waits for the GPU after swapping, costs throughput
+} hs_frame_pacer;
+
+#define HS_FRAME_PACER_INIT(fps) {.frame_ns = 1000000000ull / (fps), .spin_ns = 1000000}
+
+#define HS_RENDER_TARGET_POOL_SIZE 4
+#define HS_DYNRES_QUERIES 3
+
+typedef struct {
+        uint32_t fbo, tex, width, height;
+        uint64_t last_used;
+} hs_render_target;
+
+// render targets are kept around so toggling between sizes does not reallocate
+typedef struct {
+        hs_render_target targets[HS_RENDER_TARGET_POOL_SIZE];
+        uint64_t uses;
+} hs_render_target_pool;
+
+// renders into a scaled down part of a full size target, the scale follows
+// the measured frametime and the result is upscaled with sharp bilinear
+typedef struct {
+        float scale, min_scale, max_scale;
+        float target_ms, gpu_ms, cpu_ms;
+        uint32_t width, height, render_width, render_height;
+        uint32_t cooldown;
+        uint32_t queries[HS_DYNRES_QUERIES];
+        uint32_t query_frame;
+        uint64_t begin_ns;
+        hs_render_target target;
+        hs_render_target_pool pool;
+        uint32_t sp, vao;
+        uint32_t u_src_size, u_tex_size, u_scale;
+} hs_dynres;
+
+// per instance data of a point light, pos and radius are in world units
+typedef struct {
+        vec2 pos;
+        float radius;
+        float r, g, b;
+} hs_light;
+
+// lights are added up in a scaled down buffer that is cleared to the ambient
+// color, then multiplied over the scene. every light pushed between begin and
+// render goes out in one instanced draw
+typedef struct {
+        uint32_t fbo, tex, width, height;
+        uint32_t screen_width, screen_height;
+        uint32_t max_lights, count;
+        vec3 ambient;
+        hs_shader_program sp; // coord works like the tilemap ones
+        uint32_t composite_sp, composite_vao;
+        uint32_t occluders;   // texture, 0 when lights go through walls
+        uint32_t u_occlusion;
+        hs_light* write;
+        hs_stream_buffer stream;
+} hs_lighting;
+
+// gpu side layout of one particle
+typedef struct {
+        vec2 pos, vel;
+        float age, life; // seconds, waiting to be born while age < 0 and dead once age >= life
+} hs_particle;
+
+typedef struct {
+        vec2 pos;                   // particles spawn within radius of pos
+        float radius;
+        vec2 vel;                   // plus up to vel_spread in a random direction
+        float vel_spread;
+        vec2 gravity;
+        float life_min, life_max;   // seconds
+        float size_start, size_end; // half size in world units
+        vec4 color_start, color_end;
+        uint32_t tile, frames;      // atlas tiles from tile on, played once over the lifetime
+        bool emitting;
+} hs_particle_emitter;
+
+// the particles live in two vertex buffers, each update reads one and writes the
+// other with transform feedback so the cpu only sets the emitter uniforms
+typedef struct {
+        uint32_t count, current;    // current is the buffer with the latest state
+        uint32_t vbo[2], update_vao[2], draw_vao[2];
+        uint32_t update_sp, seed;
+        uint32_t u_dt, u_seed, u_emitting, u_emitter_pos, u_radius;
+        uint32_t u_vel, u_vel_spread, u_gravity, u_life;
+        hs_shader_program sp;       // coord works like the tilemap ones
+        uint32_t u_size, u_color_start, u_color_end, u_tile, u_frames;
+        hs_particle_emitter emitter;
+} hs_particles;
+
+// sort keys for drawing, from the top bits down: layer, depth, shader, texture.
+// items sharing a layer and depth end up grouped by shader and texture
+#define HS_DRAW_DEPTH_MAX 0xffffff
+
+typedef struct {
+        uint32_t count, cap;
+        uint64_t* keys;
+        uint32_t* order;     // item indices, in draw order after hs_draw_order_sort
+        uint64_t* tmp_keys;
+        uint32_t* tmp_order;
+} hs_draw_order;
+
+// counters for the current frame, the totals are kept across frames
+typedef struct {
+        uint32_t draw_calls, vertices, allocations, entities;
+        uint64_t buffer_bytes;
+        uint64_t texture_bytes; // live, kept across frames
+        float frametime;
+} hs_frame_stats;
+
 typedef struct {
         vec2 tr, bl;
 } hs_aabb2;
@@ -111,6 +322,27 @@ typedef struct {
         vec2 pos, half_size;
 } hs_rect2;
 
+typedef struct {
+        bool hit;
+        float time;   // fraction of the move before contact, 0 to 1
+        vec2i normal; // side of the target that was hit
+} hs_sweep2;
+
+// texel values of a hs_fog, any value in between works as a brightness
+#define HS_FOG_HIDDEN   0
+#define HS_FOG_EXPLORED 96
+#define HS_FOG_VISIBLE  255
+
+// one texel per tile multiplied into the tile color by fog_transform_frag,
+// cells keeps a copy so only the changed part is uploaded
+typedef struct {
+        uint32_t tex;
+        uint32_t width, height;
+        uint8_t* cells;
+        hs_aabb2i dirty;     // changed cells since the last upload, empty when bl > tr
+        hs_aabb2i lit;       // cells hs_fog_set_fov may have made visible
+} hs_fog;
+
 typedef struct {
         hs_rect2 r;
         uint32_t flags;
@@ -142,6 +374,14 @@ enum entity2_flags {
         DISABLED = 1 << 8,
 };
 
+enum hs_init_flags {
+        HS_NO_VSYNC = 1 << 0,
+        HS_WIREFRAME_MODE = 1 << 1,
+        HS_BLEND_MODE = 1 << 2,
+        HS_DEPTH_TESTING = 1 << 3,
+        HS_HEADLESS = 1 << 4, // invisible window with an OSMesa context
+};
+
 enum hs_key_state {
         HS_KEY_UP = 0,
         HS_KEY_DOWN = 1,
@@ -169,6 +409,20 @@ extern void     hs_clear(const float r, const  float g, const  float b, const  f
 extern void     hs_avg_frametime_print(const float delta, const float interval);
 extern void     hs_avg_fps_print(const float delta, const float interval);
 extern void     hs_fps_callback_init(const hs_game_data gd, void(*mouse_callback)(GLFWwindow*, double xpos, double ypos));
+extern uint32_t hs_fixed_step_ticks(hs_fixed_step* fs, const float delta);
+
+/* Time */
+extern uint64_t hs_time_ns();
+extern void     hs_sleep_ns(const uint64_t ns);
+extern void     hs_frame_pacer_wait(hs_frame_pacer* pacer);
+extern void     hs_frame_pacer_input(hs_frame_pacer* pacer);
+extern void     hs_frame_pacer_end_frame(hs_frame_pacer* pacer, const hs_game_data gd);
+
+/* Statistics */
+extern hs_frame_stats hs_stats_last_frame();
+extern void           hs_stats_entities_set(const uint32_t entities);
+extern void           hs_stats_texture_set(const uint32_t tex, const uint64_t bytes);
+extern void           hs_stats_frame_end();
 
 /* Vertex Buffer */
 extern uint32_t hs_vao_create(const uint32_t  count);
@@ -180,8 +434,17 @@ extern hs_vobj  hs_vobj_create(const float    *vbuff, const uint32_t vbuffsize,
                               const uint32_t *ibuff, const uint32_t ibuffsize,
                               const GLenum    usage, const uint32_t count);
 extern void     hs_vobj_free(hs_vobj vobj);
+extern void     hs_stream_buffer_init(hs_stream_buffer* sb, const uint32_t size, const uint32_t stride);
+extern void*    hs_stream_buffer_begin(hs_stream_buffer* sb, const uint32_t max_bytes);
+extern uint32_t hs_stream_buffer_end(hs_stream_buffer* sb, const uint32_t bytes);
+extern void     hs_stream_buffer_frame_end(hs_stream_buffer* sb);
+extern void     hs_stream_buffer_free(hs_stream_buffer* sb);
 extern void     hs_vattrib_enable(const uint32_t index, const uint32_t size, const GLenum type,
                                   const uint32_t stride, const size_t pointer);
+extern void     hs_vattrib_enable_int(const uint32_t index, const uint32_t size, const GLenum type,
+                                      const uint32_t stride, const size_t pointer);
+extern void     hs_vattrib_enable_norm(const uint32_t index, const uint32_t size, const GLenum type,
+                                       const uint32_t stride, const size_t pointer);
 extern void     hs_vattrib_enable_float(const uint32_t index, const uint32_t size,
                                          const uint32_t stride, const size_t pointer);
 
@@ -193,6 +456,7 @@ extern void              hs_sp_delete(hs_shader_program sp);
 extern uint32_t          hs_sp_texture_transform_create();
 extern uint32_t hs_sp_create_from_src(const char *v_src,   const char *f_src);
 extern uint32_t hs_sp_create_from_file(const char *v_file, const char *f_file);
+extern uint32_t hs_sp_feedback_create_from_src(const char *v_src, const char** varyings, const uint32_t varying_count);
 
 /* Uniforms */
 extern uint32_t hs_uniform_create(const uint32_t program, const char* name);
@@ -203,7 +467,12 @@ extern void     hs_uniform_vec2_set(const uint32_t u_vec, const vec2 vec);
 extern void     hs_uniform_sp_vec2_set(const uint32_t program, const uint32_t u_vec, const vec2 vec);
 extern void     hs_tex_uniform_set(const hs_tex tex, const uint32_t val);
 extern void     hs_tex2d_activate(const uint32_t texture_object, const GLenum texindex);
+extern void     hs_tex2d_array_activate(const uint32_t texture_object, const GLenum texindex);
+extern void     hs_tex_delete(const uint32_t texture_object);
+extern uint32_t hs_tex2d_array_create_data(const void* data, const uint32_t width, const uint32_t height, const uint32_t layers,
+                                           const GLenum format, const GLenum wrap, const GLenum filter);
 #ifndef NO_STBI
+extern uint32_t hs_tex2d_array_create(const char **filenames, const uint32_t count, const GLenum format, const GLenum wrap, const GLenum filter);
 extern uint32_t hs_tex2d_create(const char *filename, const GLenum format, const GLenum  wrap, const GLenum filter);
 extern uint32_t hs_tex2d_create_pixel(const char *filename, const GLenum format);
 extern uint32_t hs_tex2d_create_size_info(const char *filename, const GLenum format, const GLenum wrap, const GLenum filter, int* width, int* height);
@@ -214,6 +483,43 @@ extern uint32_t hs_tex2d_create_size_info_pixel(const char *filename, const GLen
 extern uint32_t hs_fbo_color_create(const uint32_t width,  const uint32_t height, uint32_t* tex);
 extern void     hs_fbo_draw_to_screen(const uint32_t fbo,  const uint32_t src_w, const uint32_t src_h,
                       const uint32_t dst_x, const uint32_t dst_y, const uint32_t dst_w, const uint32_t dst_h);
+extern hs_render_target hs_render_target_acquire(hs_render_target_pool* pool, const uint32_t width, const uint32_t height);
+extern void             hs_render_target_pool_free(hs_render_target_pool* pool);
+
+/* Dynamic resolution */
+extern void hs_dynres_init(hs_dynres* dr, const uint32_t width, const uint32_t height, const float target_ms);
+extern void hs_dynres_resize(hs_dynres* dr, const uint32_t width, const uint32_t height);
+extern void hs_dynres_begin(hs_dynres* dr);
+extern void hs_dynres_end(hs_dynres* dr);
+extern void hs_dynres_free(hs_dynres* dr);
+
+/* Lighting */
+extern void hs_lighting_init(hs_lighting* l, const uint32_t screen_width, const uint32_t screen_height,
+                             const float scale, const uint32_t max_lights);
+extern void hs_lighting_resize(hs_lighting* l, const uint32_t screen_width, const uint32_t screen_height, const float scale);
+extern void hs_lighting_begin(hs_lighting* l);
+extern void hs_lighting_push(hs_lighting* l, const hs_light light);
+extern void hs_lighting_render(hs_lighting* l);
+extern void hs_lighting_composite(const hs_lighting l);
+extern void hs_lighting_occluders_set(hs_lighting* l, const uint32_t tex, const vec2 origin, const vec2 tile_size,
+                                      const uint32_t width, const uint32_t height);
+extern void hs_lighting_free(hs_lighting* l);
+
+/* Particles */
+extern void hs_particles_init(hs_particles* ps, const uint32_t count, const hs_particle_emitter emitter,
+                              const float tileset_width, const float tileset_height);
+extern void hs_particles_update(hs_particles* ps, const float dt);
+extern void hs_particles_draw(const hs_particles ps);
+extern void hs_particles_free(hs_particles* ps);
+
+/* Draw order */
+extern uint64_t hs_draw_key(const uint8_t layer, const uint32_t depth, const uint32_t shader, const uint32_t texture);
+extern uint32_t hs_draw_depth_y(const float y, const float y_min, const float y_max);
+extern void     hs_draw_order_reserve(hs_draw_order* o, const uint32_t cap);
+extern void     hs_draw_order_clear(hs_draw_order* o);
+extern void     hs_draw_order_push(hs_draw_order* o, const uint64_t key, const uint32_t index);
+extern void     hs_draw_order_sort(hs_draw_order* o);
+extern void     hs_draw_order_free(hs_draw_order* o);
 
 /* hs_aabb2 */
 extern vec2     hs_aabb2_center(const hs_aabb2 rect);
@@ -231,6 +537,8 @@ extern uint32_t hs_bsp_recti_split_in_place_append(hs_aabb2i* rects, const uint3
 extern uint32_t hs_rect2_is_inside(const hs_rect2 r1, const hs_rect2 r2, float* lenabs);
 extern void     hs_entity2_force_inside_rects(hs_rect2* e, hs_rect2* rects, const uint32_t rectc);
 extern void     hs_entity2_collide(hs_rect2* r1, const hs_rect2* r2);
+extern hs_sweep2 hs_rect2_sweep(const hs_rect2 r, const vec2 move, const hs_rect2 target);
+extern vec2     hs_entity2_move_and_slide(hs_rect2* e, vec2 move, const hs_rect2* rects, const uint32_t rectc);
 
 /* Camera */
 extern hs_camera hs_init_fps_camera();
@@ -268,10 +576,33 @@ extern void     hs_aroom_to_tilemap(const hs_aroom aroom, hs_tilemap* tilemap, c
 extern uint8_t  hs_aroom_get_xy(const hs_aroom aroom, const uint16_t x, const uint16_t y);
 extern void     hs_aroom_set_tilemap(const hs_aroom aroom, hs_tilemap* tilemap, const uint16_t layer);
 extern void     hs_aroom_set_tilemap_offsetv(const hs_aroom aroom, hs_tilemap* tilemap, const uint16_t layer, const vec2i offset);
+extern void     hs_aroom_set_tilemap_mt(const hs_aroom aroom, hs_tilemap* tilemap, const uint16_t layer, const uint32_t threads);
+extern uint8_t* hs_aroom_layer(const hs_aroom aroom, const uint16_t layer);
+
+extern void                 hs_tileset_uv_init(hs_tileset_uv* uv, const uint32_t tileset_width, const uint32_t tileset_height);
+extern const hs_tileset_uv* hs_tileset_uv_get(const uint32_t tileset_width, const uint32_t tileset_height);
+extern hs_tile_anim_table hs_tile_anim_table_create(const uint32_t tileset_width, const uint32_t tileset_height,
+                                                     const hs_tile_anim* anims, const uint32_t count);
+extern void               hs_tile_anim_table_free(hs_tile_anim_table* table);
+extern void               hs_tile_anim_activate(const hs_tile_anim_table table);
+extern uint32_t           hs_tile_anim_sp_set(hs_shader_program* sp, const hs_tile_anim_table table);
+extern void               hs_tile_anim_time_set(const uint32_t u_time, const uint32_t ms);
+
+extern hs_fog   hs_fog_create(const uint32_t width, const uint32_t height, const uint8_t value, const GLenum filter);
+extern void     hs_fog_free(hs_fog* fog);
+extern void     hs_fog_set(hs_fog* fog, const uint32_t x, const uint32_t y, const uint8_t value);
+extern uint8_t  hs_fog_get(const hs_fog fog, const uint32_t x, const uint32_t y);
+extern void     hs_fog_upload(hs_fog* fog);
+extern void     hs_fog_activate(const hs_fog fog);
+extern void     hs_fog_sp_set(hs_shader_program* sp, const vec2 origin, const vec2 tile_size, const hs_fog fog);
+extern void     hs_fog_tilemap_sp_set(hs_tilemap* tilemap, const hs_fog fog);
+
+extern void                 hs_tilemap_set_row(hs_tilemap* tilemap, const uint32_t vertex, const uint8_t* tiles, const uint32_t count, const hs_tileset_uv* uv);
 extern vec2     hs_tilemap_pos_to_global(const hs_tilemap tilemap, vec2i pos);
 
 extern uint32_t hs_dyn_tilemap_sizeof(const hs_dyn_tilemap tilemap);
 extern void     hs_dyn_tilemap_init(hs_dyn_tilemap* tilemap, size_t size);
+extern void     hs_dyn_tilemap_init_stream(hs_dyn_tilemap* tilemap, size_t size);
 extern void     hs_dyn_tilemap_clear(hs_dyn_tilemap* tilemap);
 extern void     hs_dyn_tilemap_free(hs_dyn_tilemap* tilemap);
 extern void     hs_dyn_tilemap_push(hs_dyn_tilemap* tilemap, const vec2i pos, uint32_t tile);
@@ -280,21 +611,64 @@ extern void     hs_dyn_tilemap_update_vbo(const hs_dyn_tilemap tilemap);
 extern void     hs_dyn_tilemap_draw(const hs_dyn_tilemap tilemap);
 extern vec2     hs_dyn_tilemap_pos_to_global(const hs_dyn_tilemap tilemap, vec2i pos);
 
+extern uint32_t hs_layered_tilemap_sizeof(const hs_layered_tilemap tilemap);
+extern void     hs_layered_tilemap_init(hs_layered_tilemap* tilemap);
+extern void     hs_layered_tilemap_update_vbo(const hs_layered_tilemap tilemap);
+extern void     hs_layered_tilemap_draw(const hs_layered_tilemap tilemap);
+extern void     hs_layered_tilemap_free(hs_layered_tilemap* tilemap);
+extern void     hs_aroom_to_layered_tilemap(const hs_aroom aroom, hs_layered_tilemap* tilemap);
+extern void     hs_aroom_set_layered_tilemap(const hs_aroom aroom, hs_layered_tilemap* tilemap);
+
 /* Entity */
 extern hs_shader_program hs_sp_sprite_create(const float width, const float height, const float screen_size);
+extern hs_shader_program hs_sp_sprite_create_compact(const float width, const float height, const float screen_size);
 extern void              hs_sprite_draw_current();
 
 extern hs_entity2 hs_entity2_create(hs_entity2_hot* hot, hs_shader_program sp, hs_tex tex);
 
+#ifdef HS_NUKLEAR
+#include "hs_nuklear.h"
+#endif
+
+#ifdef HS_GL_STATS
+#include "hs_gl_stats.h"
+#endif
+
 #ifdef HS_IMPL
 static uint32_t hs_default_missing_tex = 0;
+static hs_frame_stats hs_stats = {0};
+static hs_frame_stats hs_stats_last = {0};
+// bytes of each texture indexed by GL name, so deleting one takes it out of the total
+static hs_dynarr hs_stats_texture_sizes = {0};
 
 #define GLAD_IMPL
 #include "external/glad/glad_impl.h"
 #define GLFW_IMPL
+// build glfw for the null platform so HS_HEADLESS works without a display
+#ifdef HS_GLFW_OSMESA
+#define _GLFW_OSMESA
+#endif
 #include "external/glfw/glfw_impl.h"
 
 #define hs_loop(game_data, update_func) while(hs_window_up(game_data)) {hs_poll_input(); update_func; hs_end_frame(game_data);}
+// tick_func runs 0 or more times per frame at the fixed rate, render_func once using fixed_step.alpha
+#define hs_loop_fixed(game_data, fixed_step, tick_func, render_func)                                    \
+        while(hs_window_up(game_data)) {                                                                \
+                hs_poll_input();                                                                        \
+                for (uint32_t _hs_ticks = hs_fixed_step_ticks(&(fixed_step), hs_delta()); _hs_ticks; _hs_ticks--) \
+                        tick_func;                                                                      \
+                render_func;                                                                            \
+                hs_end_frame(game_data);                                                                \
+        }
+// update_func runs once per frame, frames are paced to pacer.frame_ns
+#define hs_loop_paced(game_data, pacer, update_func)                                                    \
+        while(hs_window_up(game_data)) {                                                                \
+                hs_frame_pacer_wait(&(pacer));                                                          \
+                hs_poll_input();                                                                        \
+                hs_frame_pacer_input(&(pacer));                                                         \
+                update_func;                                                                            \
+                hs_frame_pacer_end_frame(&(pacer), game_data);                                          \
+        }
 
 inline void
 hs_clear(const float r, const  float g, const  float b, const  float a, const GLbitfield mask)
@@ -418,6 +792,24 @@ hs_vattrib_enable(const uint32_t index, const uint32_t size,
         glEnableVertexAttribArray(index);
 }
 
+// the shader input has to be an int or uint type
+inline void
+hs_vattrib_enable_int(const uint32_t index, const uint32_t size,
+                      const GLenum type, const uint32_t stride, const size_t pointer)
+{
+        glVertexAttribIPointer(index, size, type, stride, (void*)pointer);
+        glEnableVertexAttribArray(index);
+}
+
+// integers mapped to [0, 1] or [-1, 1] depending on the sign of type
+inline void
+hs_vattrib_enable_norm(const uint32_t index, const uint32_t size,
+                       const GLenum type, const uint32_t stride, const size_t pointer)
+{
+        glVertexAttribPointer(index, size, type, GL_TRUE, stride, (void*)pointer);
+        glEnableVertexAttribArray(index);
+}
+
 inline void
 hs_vattrib_enable_float(const uint32_t index, const uint32_t size,
                         const uint32_t stride, const size_t pointer)
@@ -425,17 +817,106 @@ hs_vattrib_enable_float(const uint32_t index, const uint32_t size,
         hs_vattrib_enable(index, size, GL_FLOAT, stride * sizeof(float), pointer * sizeof(float));
 }
 
+inline uint64_t
+hs_time_ns()
+{
+#ifdef WIN32
+        static LARGE_INTEGER freq = {0};
+        if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        // split to avoid overflowing when multiplying
+        return (counter.QuadPart / freq.QuadPart) * 1000000000ull +
+               (counter.QuadPart % freq.QuadPart) * 1000000000ull / freq.QuadPart;
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+inline void
+hs_sleep_ns(const uint64_t ns)
+{
+#ifdef WIN32
+        // Sleep rounds up to the 15.6 ms timer tick, the high resolution timer (windows 10
+        // 1803 and later) does not
+        static HANDLE timer = NULL;
+        static bool timer_tried = false;
+        if (!timer_tried) {
+                timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+                // older windows, Sleep gets 1 ms granularity for the rest of the program instead
+                if (!timer) timeBeginPeriod(1);
+                timer_tried = true;
+        }
+        if (timer) {
+                // negative is relative, in 100 ns units
+                LARGE_INTEGER due = {.QuadPart = -(LONGLONG)(ns / 100)};
+                SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE);
+                WaitForSingleObject(timer, INFINITE);
+        } else if (ns > 2000000) {
+                // a millisecond short rather than long, hs_frame_pacer_wait busy waits the rest
+                Sleep(ns / 1000000 - 1);
+        }
+#else
+        struct timespec ts = {.tv_sec = ns / 1000000000ull, .tv_nsec = ns % 1000000000ull};
+        while (nanosleep(&ts, &ts) == -1);
+#endif
+}
+
+// the difference is taken in integer nanoseconds, so precision does not degrade with uptime
 inline float
 hs_delta()
 {
-        static float last_frame = 0.0f;
-        float current_frame = glfwGetTime() * 1000.0f;
-        float delta = current_frame - last_frame;
+        static uint64_t last_frame = 0;
+        const uint64_t current_frame = hs_time_ns();
+        const float delta = last_frame ? (current_frame - last_frame) / 1000000.0 : 0.0f;
 
         last_frame = current_frame;
         return delta;
 }
 
+void
+hs_frame_pacer_wait(hs_frame_pacer* pacer)
+{
+        const uint64_t now = hs_time_ns();
+
+        // first frame or a missed deadline, start over instead of rushing the next frames to catch up
+        if (now >= pacer->deadline) {
+                pacer->deadline = now + pacer->frame_ns;
+                return;
+        }
+
+        if (pacer->deadline > now + pacer->spin_ns)
+                hs_sleep_ns(pacer->deadline - now - pacer->spin_ns);
+        while (hs_time_ns() < pacer->deadline);
+
+        pacer->deadline += pacer->frame_ns;
+}
+
+inline void
+hs_frame_pacer_input(hs_frame_pacer* pacer)
+{
+        pacer->input_ns = hs_time_ns();
+}
+
+inline uint32_t
+hs_fixed_step_ticks(hs_fixed_step* fs, const float delta)
+{
+        fs->accumulator += delta;
+
+        // can't keep up, drop the time instead of spiraling into longer and longer frames
+        const float max_accumulated = fs->tick * fs->max_ticks;
+        if (fs->accumulator > max_accumulated) fs->accumulator = max_accumulated;
+
+        const uint32_t ticks = fs->accumulator / fs->tick;
+        fs->accumulator -= ticks * fs->tick;
+        fs->alpha = fs->accumulator / fs->tick;
+
+        return ticks;
+}
+
 inline void
 hs_sp_use(const hs_shader_program sp)
 {
@@ -560,6 +1041,33 @@ hs_sp_create_from_file(const char *v_file, const char *f_file)
         return sp;
 }
 
+// vertex shader only program whose outputs are captured interleaved, in varyings order
+uint32_t
+hs_sp_feedback_create_from_src(const char *v_src, const char** varyings, const uint32_t varying_count)
+{
+        uint32_t v_shader = hs_shader_create(v_src, GL_VERTEX_SHADER);
+        uint32_t program = glCreateProgram();
+        glAttachShader(program, v_shader);
+        glTransformFeedbackVaryings(program, varying_count, varyings, GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(program);
+
+        int  program_link_success;
+        glGetProgramiv(program, GL_LINK_STATUS, &program_link_success);
+
+        if (!program_link_success) {
+                char info_log[512];
+                glGetProgramInfoLog(program, 512, NULL, info_log);
+                fprintf(stderr, "-------------ERROR------------\n"
+                       "::OpenGL Failed to link program::\n%s\n", info_log);
+                assert(program_link_success);
+        }
+
+        glDeleteShader(v_shader);
+
+        glUseProgram(program);
+        return program;
+}
+
 inline uint32_t
 hs_fbo_color_create(const uint32_t width, const uint32_t height, uint32_t* tex)
 {
@@ -572,6 +1080,7 @@ hs_fbo_color_create(const uint32_t width, const uint32_t height, uint32_t* tex)
 
         // create attached texture
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        hs_stats_texture_set(*tex, (uint64_t)width * height * 3);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *tex, 0);
@@ -593,118 +1102,714 @@ hs_fbo_draw_to_screen(const uint32_t fbo, const uint32_t src_w, const uint32_t s
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
 }
 
-inline hs_shader_program
-hs_shader_program_create(const uint32_t sp, hs_vobj vobj)
+hs_render_target
+hs_render_target_acquire(hs_render_target_pool* pool, const uint32_t width, const uint32_t height)
 {
-        return (hs_shader_program) {
-                .p = sp,
-                .vobj = vobj,
-        };
+        pool->uses++;
+
+        uint32_t lru = 0;
+        for (uint32_t i = 0; i < HS_RENDER_TARGET_POOL_SIZE; i++) {
+                hs_render_target* t = &pool->targets[i];
+                if (t->fbo && t->width == width && t->height == height) {
+                        t->last_used = pool->uses;
+                        return *t;
+                }
+                if (t->last_used < pool->targets[lru].last_used) lru = i;
+        }
+
+        hs_render_target* t = &pool->targets[lru];
+        if (t->fbo) {
+                glDeleteFramebuffers(1, &t->fbo);
+                hs_tex_delete(t->tex);
+        }
+
+        t->fbo = hs_fbo_color_create(width, height, &t->tex);
+        t->width = width;
+        t->height = height;
+        t->last_used = pool->uses;
+
+        // the sharp bilinear upscale relies on linear filtering
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        return *t;
 }
 
-inline void
-hs_sp_delete(hs_shader_program sp)
+void
+hs_render_target_pool_free(hs_render_target_pool* pool)
 {
-        glDeleteProgram(sp.p);
-        hs_vobj_free(sp.vobj);
+        for (uint32_t i = 0; i < HS_RENDER_TARGET_POOL_SIZE; i++) {
+                if (!pool->targets[i].fbo) continue;
+                glDeleteFramebuffers(1, &pool->targets[i].fbo);
+                hs_tex_delete(pool->targets[i].tex);
+        }
+        *pool = (hs_render_target_pool){0};
 }
 
-inline void
-hs_avg_frametime_print(const float delta, const float interval)
+void
+hs_dynres_init(hs_dynres* dr, const uint32_t width, const uint32_t height, const float target_ms)
 {
-        static float prev = 0.0f;
-        static float acum = 0.0f;
-        static uint32_t times = 0;
-        prev += delta;
-        acum += delta;
-        times++;
+        if (dr->min_scale <= 0.0f) dr->min_scale = 0.5f;
+        if (dr->max_scale <= 0.0f) dr->max_scale = 1.0f;
+        if (dr->scale     <= 0.0f) dr->scale = dr->max_scale;
+        dr->target_ms = target_ms;
 
-        if (prev > interval) {
-                printf("avg frametime: %f\n", (acum/times));
-                prev = 0.0f;
-                acum = 0.0f;
-                times = 0;
-        }
+        dr->sp = hs_sp_create_from_src(fullscreen_vert, sharp_bilinear_frag);
+        hs_tex_uniform_set(hs_uniform_create(dr->sp, "u_tex"), 0);
+        dr->u_src_size = hs_uniform_create(dr->sp, "u_src_size");
+        dr->u_tex_size = hs_uniform_create(dr->sp, "u_tex_size");
+        dr->u_scale    = hs_uniform_create(dr->sp, "u_scale");
+
+        // core profile needs a vao bound to draw, even without attributes
+        glGenVertexArrays(1, &dr->vao);
+        glGenQueries(HS_DYNRES_QUERIES, dr->queries);
+
+        hs_dynres_resize(dr, width, height);
 }
 
 inline void
-hs_avg_fps_print(const float delta, const float interval)
+hs_dynres_resize(hs_dynres* dr, const uint32_t width, const uint32_t height)
 {
-        static float prev = 0.0f;
-        static float acum = 0.0f;
-        static uint32_t times = 0;
-        prev += delta;
-        acum += delta;
-        times++;
+        dr->width = width;
+        dr->height = height;
+        dr->target = hs_render_target_acquire(&dr->pool, width, height);
+}
 
-        if (prev > interval) {
-                printf("avg fps: %f\n", 1000/(acum/times));
-                prev = 0.0f;
-                acum = 0.0f;
-                times = 0;
+void
+hs_dynres_begin(hs_dynres* dr)
+{
+        dr->begin_ns = hs_time_ns();
+        dr->render_width  = max(1, dr->width  * dr->scale);
+        dr->render_height = max(1, dr->height * dr->scale);
+
+        // results from older frames are read back here, so the GPU is never waited on
+        const uint32_t query = dr->queries[dr->query_frame % HS_DYNRES_QUERIES];
+        if (dr->query_frame >= HS_DYNRES_QUERIES) {
+                int available = 0;
+                glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) {
+                        uint64_t elapsed;
+                        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                        dr->gpu_ms = elapsed / 1000000.0;
+                }
         }
+        glBeginQuery(GL_TIME_ELAPSED, query);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, dr->target.fbo);
+        glViewport(0, 0, dr->render_width, dr->render_height);
 }
 
-inline void
-hs_tex_uniform_set(const uint32_t u_tex, const uint32_t tex)
-{
-        glUniform1i(u_tex, tex);
+void
+hs_dynres_end(hs_dynres* dr)
+{
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, dr->width, dr->height);
+
+        glUseProgram(dr->sp);
+        glBindVertexArray(dr->vao);
+        hs_tex2d_activate(dr->target.tex, GL_TEXTURE0);
+        glUniform2f(dr->u_src_size, dr->render_width, dr->render_height);
+        glUniform2f(dr->u_tex_size, dr->target.width, dr->target.height);
+        glUniform2f(dr->u_scale, (float)dr->width / dr->render_width, (float)dr->height / dr->render_height);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 3;
+
+        glEndQuery(GL_TIME_ELAPSED);
+        dr->query_frame++;
+        dr->cpu_ms = (hs_time_ns() - dr->begin_ns) / 1000000.0;
+
+        if (dr->cooldown) {
+                dr->cooldown--;
+                return;
+        }
+
+        // cost scales with the pixel count, so with the square of the scale
+        const float headroom = dr->target_ms * 0.9f;
+        float new_scale = dr->scale;
+        if (dr->gpu_ms > dr->target_ms * 0.95f)
+                new_scale = dr->scale * max(sqrtf(headroom / dr->gpu_ms), 0.85f);
+        else if (dr->gpu_ms < dr->target_ms * 0.75f && dr->cpu_ms < dr->target_ms)
+                new_scale = dr->scale * min(sqrtf(headroom / max(dr->gpu_ms, 0.001f)), 1.05f);
+
+        CLAMP(new_scale, dr->min_scale, dr->max_scale);
+        if (fabsf(new_scale - dr->scale) > 0.01f) {
+                dr->scale = new_scale;
+                // let the change show up in the timings before adjusting again
+                dr->cooldown = HS_DYNRES_QUERIES + 2;
+        }
 }
 
-inline void
-hs_tex2d_activate(const uint32_t texture_object, const GLenum texindex)
+void
+hs_dynres_free(hs_dynres* dr)
 {
-        glActiveTexture(texindex);
-        glBindTexture(GL_TEXTURE_2D, texture_object);
+        hs_render_target_pool_free(&dr->pool);
+        glDeleteQueries(HS_DYNRES_QUERIES, dr->queries);
+        glDeleteVertexArrays(1, &dr->vao);
+        glDeleteProgram(dr->sp);
 }
 
-#ifndef NO_STBI
-uint32_t
-hs_tex2d_create(const char *filename, const GLenum format,
-                const GLenum wrap, const GLenum filter)
-{
-        uint32_t tex;
-        glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
+void
+hs_lighting_init(hs_lighting* l, const uint32_t screen_width, const uint32_t screen_height,
+                 const float scale, const uint32_t max_lights)
+{
+        assert(max_lights);
+        l->max_lights = max_lights;
+        l->count = 0;
+        hs_lighting_resize(l, screen_width, screen_height, scale);
+
+        l->sp.p = hs_sp_create_from_src(light_vert, light_frag);
+        l->sp.coord = hs_uniform_coord_create(l->sp.p, "u_model", "u_view", "u_proj");
+        hs_uniform_mat4_set(l->sp.coord.proj, (mat4)MAT4_IDENTITY);
+        hs_tex_uniform_set(hs_uniform_create(l->sp.p, "u_occluders"), 1);
+        l->u_occlusion = hs_uniform_create(l->sp.p, "u_occlusion");
+        glUniform1i(l->u_occlusion, 0);
+
+        // the attribute pointers move with the stream section, hs_lighting_render sets them
+        l->sp.vobj.vao = hs_vao_create(1);
+        hs_stream_buffer_init(&l->stream, sizeof(hs_light) * max_lights, sizeof(hs_light));
+        l->sp.vobj.vbo = l->stream.vbo;
+        for (uint32_t i = 0; i < 3; i++) {
+                glEnableVertexAttribArray(i);
+                glVertexAttribDivisor(i, 1);
+        }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        l->composite_sp = hs_sp_create_from_src(fullscreen_vert, light_composite_frag);
+        hs_tex_uniform_set(hs_uniform_create(l->composite_sp, "u_tex"), 0);
+        glGenVertexArrays(1, &l->composite_vao);
 
-        int width, height, nr_channels;
-        unsigned char* texture_data = stbi_load(filename, &width, &height, &nr_channels, 0);
-        if (!texture_data) {
-                fprintf(stderr, "---error loading texture \"%s\"--\n", filename);
-                assert(texture_data);
+        l->write = hs_stream_buffer_begin(&l->stream, l->stream.size);
+}
+
+// the light buffer is scale times the screen size, lights are soft so 0.25 to 0.5 is usually enough
+void
+hs_lighting_resize(hs_lighting* l, const uint32_t screen_width, const uint32_t screen_height, const float scale)
+{
+        if (l->fbo) {
+                glDeleteFramebuffers(1, &l->fbo);
+                hs_tex_delete(l->tex);
         }
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, texture_data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(texture_data);
+        l->screen_width  = screen_width;
+        l->screen_height = screen_height;
+        l->width  = max(1, screen_width  * scale);
+        l->height = max(1, screen_height * scale);
+
+        GLint fbo;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+        l->fbo = hs_fbo_color_create(l->width, l->height, &l->tex);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
 
-        return tex;
+        // linear so the upscale in the composite smooths the light edges
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
-inline uint32_t
-hs_tex2d_create_pixel(const char *filename, const GLenum format)
+// once per frame before pushing lights, the lights of the last frame are dropped
+void
+hs_lighting_begin(hs_lighting* l)
 {
-        return hs_tex2d_create(filename, format, GL_REPEAT, GL_NEAREST);
+        if (l->write) hs_stream_buffer_end(&l->stream, 0);
+        hs_stream_buffer_frame_end(&l->stream);
+        l->write = hs_stream_buffer_begin(&l->stream, l->stream.size);
+        l->count = 0;
 }
 
-inline uint32_t
-hs_tex2d_create_size_info_pixel(const char *filename, const GLenum format, int* width, int* height)
+inline void
+hs_lighting_push(hs_lighting* l, const hs_light light)
 {
-        return hs_tex2d_create_size_info(filename, format, GL_REPEAT, GL_NEAREST, width, height);
+        assert(l->write);
+        if (l->count >= l->max_lights) {
+                fprintf(stderr, "---error more than %u lights pushed---\n", l->max_lights);
+                assert(l->count < l->max_lights);
+                return;
+        }
+        l->write[l->count++] = light;
 }
 
-uint32_t
-hs_tex2d_create_size_info(const char *filename, const GLenum format,
-                          const GLenum  wrap, const GLenum filter,
-                          int* width, int* height)
+// fills the light buffer, the bound framebuffer and viewport are kept
+void
+hs_lighting_render(hs_lighting* l)
 {
-        uint32_t tex;
-        glGenTextures(1, &tex);
-        glBindTexture(GL_TEXTURE_2D, tex);
+        const uint32_t first = hs_stream_buffer_end(&l->stream, sizeof(hs_light) * l->count);
+        l->write = NULL;
+
+        GLint fbo, viewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, l->fbo);
+        glViewport(0, 0, l->width, l->height);
+        hs_clear(l->ambient.r, l->ambient.g, l->ambient.b, 1.0f, 0);
+
+        if (l->count) {
+                GLint src, dst;
+                const GLboolean blend = glIsEnabled(GL_BLEND);
+                glGetIntegerv(GL_BLEND_SRC_RGB, &src);
+                glGetIntegerv(GL_BLEND_DST_RGB, &dst);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+
+                hs_sp_use(l->sp);
+                if (l->occluders) {
+                        hs_tex2d_activate(l->occluders, GL_TEXTURE1);
+                        glActiveTexture(GL_TEXTURE0);
+                }
+                glBindBuffer(GL_ARRAY_BUFFER, l->stream.vbo);
+                const size_t offset = (size_t)first * sizeof(hs_light);
+                hs_vattrib_enable(0, 2, GL_FLOAT, sizeof(hs_light), offset + offsetof(hs_light, pos));
+                hs_vattrib_enable(1, 1, GL_FLOAT, sizeof(hs_light), offset + offsetof(hs_light, radius));
+                hs_vattrib_enable(2, 3, GL_FLOAT, sizeof(hs_light), offset + offsetof(hs_light, r));
+                glDrawArraysInstanced(GL_TRIANGLES, 0, 6, l->count);
+                hs_stats.draw_calls++;
+                hs_stats.vertices += 6 * l->count;
+
+                glBlendFunc(src, dst);
+                if (!blend) glDisable(GL_BLEND);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+// multiplies the light buffer over whatever is in the bound framebuffer
+void
+hs_lighting_composite(const hs_lighting l)
+{
+        GLint src, dst;
+        const GLboolean blend = glIsEnabled(GL_BLEND);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &src);
+        glGetIntegerv(GL_BLEND_DST_RGB, &dst);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_DST_COLOR, GL_ZERO);
+
+        glUseProgram(l.composite_sp);
+        glBindVertexArray(l.composite_vao);
+        hs_tex2d_activate(l.tex, GL_TEXTURE0);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 3;
+
+        glBlendFunc(src, dst);
+        if (!blend) glDisable(GL_BLEND);
+}
+
+// tex has one texel per tile, red above 0.5 blocks light, and is bound to unit 1 while
+// the lights are drawn. origin is the bottom left corner of tile (0, 0) and tile_size
+// the size of one tile, like hs_grid. tex 0 turns occlusion off
+void
+hs_lighting_occluders_set(hs_lighting* l, const uint32_t tex, const vec2 origin, const vec2 tile_size,
+                          const uint32_t width, const uint32_t height)
+{
+        l->occluders = tex;
+        glUseProgram(l->sp.p);
+        glUniform1i(l->u_occlusion, tex != 0);
+        if (!tex) return;
+
+        hs_uniform_vec2_set(hs_uniform_create(l->sp.p, "u_occ_origin"), origin);
+        hs_uniform_vec2_set(hs_uniform_create(l->sp.p, "u_occ_scale"),
+                            (vec2){1.0f / (tile_size.x * width), 1.0f / (tile_size.y * height)});
+        hs_uniform_vec2_set(hs_uniform_create(l->sp.p, "u_occ_size"), (vec2){width, height});
+}
+
+void
+hs_lighting_free(hs_lighting* l)
+{
+        if (l->write) hs_stream_buffer_end(&l->stream, 0);
+        hs_stream_buffer_free(&l->stream);
+        glDeleteFramebuffers(1, &l->fbo);
+        hs_tex_delete(l->tex);
+        glDeleteVertexArrays(1, &l->sp.vobj.vao);
+        glDeleteVertexArrays(1, &l->composite_vao);
+        glDeleteProgram(l->sp.p);
+        glDeleteProgram(l->composite_sp);
+        *l = (hs_lighting){0};
+}
+
+void
+hs_particles_init(hs_particles* ps, const uint32_t count, const hs_particle_emitter emitter,
+                  const float tileset_width, const float tileset_height)
+{
+        assert(count);
+        *ps = (hs_particles){.count = count, .emitter = emitter};
+
+        const char* varyings[] = {"Pos", "Vel", "Age", "Life"};
+        ps->update_sp     = hs_sp_feedback_create_from_src(particle_update_vert, varyings, 4);
+        ps->u_dt          = hs_uniform_create(ps->update_sp, "u_dt");
+        ps->u_seed        = hs_uniform_create(ps->update_sp, "u_seed");
+        ps->u_emitting    = hs_uniform_create(ps->update_sp, "u_emitting");
+        ps->u_emitter_pos = hs_uniform_create(ps->update_sp, "u_emitter_pos");
+        ps->u_radius      = hs_uniform_create(ps->update_sp, "u_radius");
+        ps->u_vel         = hs_uniform_create(ps->update_sp, "u_vel");
+        ps->u_vel_spread  = hs_uniform_create(ps->update_sp, "u_vel_spread");
+        ps->u_gravity     = hs_uniform_create(ps->update_sp, "u_gravity");
+        ps->u_life        = hs_uniform_create(ps->update_sp, "u_life");
+
+        ps->sp.p = hs_sp_create_from_src(particle_vert, particle_frag);
+        ps->sp.coord = hs_uniform_coord_create(ps->sp.p, "u_model", "u_view", "u_proj");
+        hs_uniform_mat4_set(ps->sp.coord.proj, (mat4)MAT4_IDENTITY);
+        hs_tex_uniform_set(hs_uniform_create(ps->sp.p, "u_tex"), 0);
+        hs_uniform_vec2_set(hs_uniform_create(ps->sp.p, "u_tileset_size"), (vec2){tileset_width, tileset_height});
+        ps->u_size        = hs_uniform_create(ps->sp.p, "u_size");
+        ps->u_color_start = hs_uniform_create(ps->sp.p, "u_color_start");
+        ps->u_color_end   = hs_uniform_create(ps->sp.p, "u_color_end");
+        ps->u_tile        = hs_uniform_create(ps->sp.p, "u_tile");
+        ps->u_frames      = hs_uniform_create(ps->sp.p, "u_frames");
+
+        // births are spread over the first lifetime so the emitter starts out steady
+        hs_particle* particles = calloc(count, sizeof(hs_particle));
+        assert(particles);
+        for (uint32_t i = 0; i < count; i++)
+                particles[i].age = -emitter.life_max * i / count;
+
+        glGenBuffers(2, ps->vbo);
+        glGenVertexArrays(2, ps->update_vao);
+        glGenVertexArrays(2, ps->draw_vao);
+        for (uint32_t b = 0; b < 2; b++) {
+                glBindBuffer(GL_ARRAY_BUFFER, ps->vbo[b]);
+                glBufferData(GL_ARRAY_BUFFER, sizeof(hs_particle) * count, particles, GL_DYNAMIC_COPY);
+                hs_stats.buffer_bytes += sizeof(hs_particle) * count;
+
+                glBindVertexArray(ps->update_vao[b]);
+                hs_vattrib_enable(0, 2, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, pos));
+                hs_vattrib_enable(1, 2, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, vel));
+                hs_vattrib_enable(2, 1, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, age));
+                hs_vattrib_enable(3, 1, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, life));
+
+                glBindVertexArray(ps->draw_vao[b]);
+                hs_vattrib_enable(0, 2, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, pos));
+                hs_vattrib_enable(2, 1, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, age));
+                hs_vattrib_enable(3, 1, GL_FLOAT, sizeof(hs_particle), offsetof(hs_particle, life));
+                glVertexAttribDivisor(0, 1);
+                glVertexAttribDivisor(2, 1);
+                glVertexAttribDivisor(3, 1);
+        }
+        free(particles);
+        ps->sp.vobj.vao = ps->draw_vao[0];
+        ps->sp.vobj.vbo = ps->vbo[0];
+}
+
+// steps every particle by dt on the gpu, changes to ps->emitter apply from here on
+void
+hs_particles_update(hs_particles* ps, const float dt)
+{
+        const hs_particle_emitter e = ps->emitter;
+        glUseProgram(ps->update_sp);
+        glUniform1f(ps->u_dt, dt);
+        glUniform1ui(ps->u_seed, ps->seed++ * 2246822519u);
+        glUniform1i(ps->u_emitting, e.emitting);
+        hs_uniform_vec2_set(ps->u_emitter_pos, e.pos);
+        glUniform1f(ps->u_radius, e.radius);
+        hs_uniform_vec2_set(ps->u_vel, e.vel);
+        glUniform1f(ps->u_vel_spread, e.vel_spread);
+        hs_uniform_vec2_set(ps->u_gravity, e.gravity);
+        glUniform2f(ps->u_life, e.life_min, e.life_max);
+
+        const uint32_t next = !ps->current;
+        glBindVertexArray(ps->update_vao[ps->current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, ps->vbo[next]);
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, ps->count);
+        glEndTransformFeedback();
+        glDisable(GL_RASTERIZER_DISCARD);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += ps->count;
+
+        ps->current = next;
+        ps->sp.vobj.vao = ps->draw_vao[next];
+        ps->sp.vobj.vbo = ps->vbo[next];
+}
+
+// the atlas is whatever is bound to texture unit 0, like the tilemaps
+void
+hs_particles_draw(const hs_particles ps)
+{
+        const hs_particle_emitter e = ps.emitter;
+        hs_sp_use(ps.sp);
+        glUniform2f(ps.u_size, e.size_start, e.size_end);
+        glUniform4fv(ps.u_color_start, 1, e.color_start.rgba);
+        glUniform4fv(ps.u_color_end, 1, e.color_end.rgba);
+        glUniform1ui(ps.u_tile, e.tile);
+        glUniform1ui(ps.u_frames, max(e.frames, 1));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, ps.count);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6 * ps.count;
+}
+
+void
+hs_particles_free(hs_particles* ps)
+{
+        glDeleteBuffers(2, ps->vbo);
+        glDeleteVertexArrays(2, ps->update_vao);
+        glDeleteVertexArrays(2, ps->draw_vao);
+        glDeleteProgram(ps->update_sp);
+        glDeleteProgram(ps->sp.p);
+        *ps = (hs_particles){0};
+}
+
+// shader and texture are gl names, only their low 16 bits are used for grouping
+inline uint64_t
+hs_draw_key(const uint8_t layer, const uint32_t depth, const uint32_t shader, const uint32_t texture)
+{
+        return (uint64_t)layer << 56 | (uint64_t)(depth & HS_DRAW_DEPTH_MAX) << 32 |
+               (uint64_t)(shader & 0xffff) << 16 | (texture & 0xffff);
+}
+
+// top down ordering, higher y is further back and drawn first
+inline uint32_t
+hs_draw_depth_y(const float y, const float y_min, const float y_max)
+{
+        float t = (y_max - y) / (y_max - y_min);
+        CLAMP(t, 0.0f, 1.0f);
+        return t * HS_DRAW_DEPTH_MAX;
+}
+
+void
+hs_draw_order_reserve(hs_draw_order* o, const uint32_t cap)
+{
+        if (cap <= o->cap) return;
+
+        uint64_t* keys = malloc((sizeof(uint64_t) + sizeof(uint32_t)) * 2 * (size_t)cap);
+        assert(keys);
+        hs_alloc_count++;
+
+        uint64_t* tmp_keys = keys + cap;
+        uint32_t* order = (uint32_t*)(tmp_keys + cap);
+        memcpy(keys, o->keys, sizeof(uint64_t) * o->count);
+        memcpy(order, o->order, sizeof(uint32_t) * o->count);
+        free(o->keys);
+
+        o->keys = keys;
+        o->tmp_keys = tmp_keys;
+        o->order = order;
+        o->tmp_order = order + cap;
+        o->cap = cap;
+}
+
+inline void
+hs_draw_order_clear(hs_draw_order* o)
+{
+        o->count = 0;
+}
+
+// index is whatever the caller uses to find the item again, usually its array index
+inline void
+hs_draw_order_push(hs_draw_order* o, const uint64_t key, const uint32_t index)
+{
+        if (o->count == o->cap) hs_draw_order_reserve(o, max(o->cap * 2, 256));
+        o->keys[o->count] = key;
+        o->order[o->count] = index;
+        o->count++;
+}
+
+// stable, items with equal keys stay in push order
+inline void
+hs_draw_order_sort(hs_draw_order* o)
+{
+        hs_radix_sort64(o->keys, o->order, o->tmp_keys, o->tmp_order, o->count);
+}
+
+void
+hs_draw_order_free(hs_draw_order* o)
+{
+        free(o->keys);
+        *o = (hs_draw_order){0};
+}
+
+inline hs_shader_program
+hs_shader_program_create(const uint32_t sp, hs_vobj vobj)
+{
+        return (hs_shader_program) {
+                .p = sp,
+                .vobj = vobj,
+        };
+}
+
+inline void
+hs_sp_delete(hs_shader_program sp)
+{
+        glDeleteProgram(sp.p);
+        hs_vobj_free(sp.vobj);
+}
+
+inline void
+hs_avg_frametime_print(const float delta, const float interval)
+{
+        static float prev = 0.0f;
+        static float acum = 0.0f;
+        static uint32_t times = 0;
+        prev += delta;
+        acum += delta;
+        times++;
+
+        if (prev > interval) {
+                printf("avg frametime: %f\n", (acum/times));
+                prev = 0.0f;
+                acum = 0.0f;
+                times = 0;
+        }
+}
+
+inline void
+hs_avg_fps_print(const float delta, const float interval)
+{
+        static float prev = 0.0f;
+        static float acum = 0.0f;
+        static uint32_t times = 0;
+        prev += delta;
+        acum += delta;
+        times++;
+
+        if (prev > interval) {
+                printf("avg fps: %f\n", 1000/(acum/times));
+                prev = 0.0f;
+                acum = 0.0f;
+                times = 0;
+        }
+}
+
+inline void
+hs_tex_uniform_set(const uint32_t u_tex, const uint32_t tex)
+{
+        glUniform1i(u_tex, tex);
+}
+
+inline void
+hs_tex2d_activate(const uint32_t texture_object, const GLenum texindex)
+{
+        glActiveTexture(texindex);
+        glBindTexture(GL_TEXTURE_2D, texture_object);
+}
+
+inline void
+hs_tex2d_array_activate(const uint32_t texture_object, const GLenum texindex)
+{
+        glActiveTexture(texindex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture_object);
+}
+
+// glDeleteTextures that also takes the texture out of hs_stats.texture_bytes
+inline void
+hs_tex_delete(const uint32_t texture_object)
+{
+        hs_stats_texture_set(texture_object, 0);
+        glDeleteTextures(1, &texture_object);
+}
+
+// data holds the layers one after the other, all the same size
+uint32_t
+hs_tex2d_array_create_data(const void* data, const uint32_t width, const uint32_t height, const uint32_t layers,
+                           const GLenum format, const GLenum wrap, const GLenum filter)
+{
+        uint32_t tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, layers, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        const uint32_t channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+        hs_stats_texture_set(tex, (uint64_t)width * height * layers * channels * 4 / 3);
+
+        return tex;
+}
+
+#ifndef NO_STBI
+// every image becomes one slice, they must all have the same size
+uint32_t
+hs_tex2d_array_create(const char **filenames, const uint32_t count, const GLenum format, const GLenum wrap, const GLenum filter)
+{
+        const uint32_t channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_RG ? 2 : 1;
+        uint8_t* data = NULL;
+        int width = 0, height = 0;
+
+        for (uint32_t i = 0; i < count; i++) {
+                int w, h, nr_channels;
+                unsigned char* texture_data = stbi_load(filenames[i], &w, &h, &nr_channels, channels);
+                if (!texture_data) {
+                        fprintf(stderr, "---error loading texture \"%s\"--\n", filenames[i]);
+                        assert(texture_data);
+                }
+
+                if (!data) {
+                        width = w;
+                        height = h;
+                        data = malloc((size_t)width * height * channels * count);
+                        assert(data);
+                        hs_alloc_count++;
+                }
+                if (w != width || h != height) {
+                        fprintf(stderr, "---error texture \"%s\" is %dx%d, the array is %dx%d---\n",
+                                filenames[i], w, h, width, height);
+                        assert(w == width && h == height);
+                }
+
+                memcpy(data + (size_t)width * height * channels * i, texture_data, (size_t)width * height * channels);
+                stbi_image_free(texture_data);
+        }
+
+        const uint32_t tex = hs_tex2d_array_create_data(data, width, height, count, format, wrap, filter);
+        free(data);
+        return tex;
+}
+
+uint32_t
+hs_tex2d_create(const char *filename, const GLenum format,
+                const GLenum wrap, const GLenum filter)
+{
+        uint32_t tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+        int width, height, nr_channels;
+        unsigned char* texture_data = stbi_load(filename, &width, &height, &nr_channels, 0);
+        if (!texture_data) {
+                fprintf(stderr, "---error loading texture \"%s\"--\n", filename);
+                assert(texture_data);
+        }
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, texture_data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        // mipmaps add roughly a third
+        hs_stats_texture_set(tex, (uint64_t)width * height * nr_channels * 4 / 3);
+        stbi_image_free(texture_data);
+
+        return tex;
+}
+
+inline uint32_t
+hs_tex2d_create_pixel(const char *filename, const GLenum format)
+{
+        return hs_tex2d_create(filename, format, GL_REPEAT, GL_NEAREST);
+}
+
+inline uint32_t
+hs_tex2d_create_size_info_pixel(const char *filename, const GLenum format, int* width, int* height)
+{
+        return hs_tex2d_create_size_info(filename, format, GL_REPEAT, GL_NEAREST, width, height);
+}
+
+uint32_t
+hs_tex2d_create_size_info(const char *filename, const GLenum format,
+                          const GLenum  wrap, const GLenum filter,
+                          int* width, int* height)
+{
+        uint32_t tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
@@ -719,6 +1824,7 @@ hs_tex2d_create_size_info(const char *filename, const GLenum format,
         }
         glTexImage2D(GL_TEXTURE_2D, 0, format, *width, *height, 0, format, GL_UNSIGNED_BYTE, texture_data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        hs_stats_texture_set(tex, (uint64_t)*width * *height * nr_channels * 4 / 3);
         stbi_image_free(texture_data);
 
         return tex;
@@ -884,23 +1990,114 @@ hs_entity2_collide(hs_rect2* r1, const hs_rect2* r2)
 
         if (fabs(diff.x) >= distance.x || fabs(diff.y) >= distance.y) return;
 
-        if (diff.x == 0) diff.x = random_float_negative() * 0.00000001;
-        if (diff.y == 0) diff.y = random_float_negative() * 0.00000001;
+        // centers on top of each other push towards positive, the same result every time
         const vec2 diffabs = {fabs(diff.x), fabs(diff.y)};
 
         const float extra = 1.0001;
 
         if (diffabs.x > diffabs.y) {
-                const float mul = (diff.x / diffabs.x) * extra;
+                const float mul = (diff.x >= 0.0f ? 1.0f : -1.0f) * extra;
                 r1->pos = vec2_add(r2->pos, (vec2){distance.x * mul, diff.y});
         } else {
-                const float mul = (diff.y / diffabs.y) * extra;
+                const float mul = (diff.y >= 0.0f ? 1.0f : -1.0f) * extra;
                 r1->pos = vec2_add(r2->pos, (vec2){diff.x, distance.y * mul});
         }
         //static uint32_t col = 0;
         //printf("collisions %d\n", col++);
 }
 
+#define HS_SWEEP_SKIN 0.00001f
+#define HS_SLIDE_ITERATIONS 3
+
+// entry and exit time of r moving along one axis against target, false when they never overlap on it.
+// gaps smaller than HS_SWEEP_SKIN count as touching so a rect resting on an edge still hits it
+static inline bool
+hs_rect2_sweep_axis(const float pos, const float half, const float move, const float target_pos, const float target_half,
+                    float* entry, float* exit)
+{
+        const float lo = target_pos - target_half - (pos + half);
+        const float hi = target_pos + target_half - (pos - half);
+
+        if (move == 0.0f) {
+                if (lo > -HS_SWEEP_SKIN || hi < HS_SWEEP_SKIN) return false;
+                *entry = -INFINITY;
+                *exit = INFINITY;
+                return true;
+        }
+
+        float gap_entry = move > 0.0f ? lo : -hi;
+        const float gap_exit = move > 0.0f ? hi : -lo;
+        if (gap_entry < 0.0f && gap_entry > -HS_SWEEP_SKIN) gap_entry = 0.0f;
+
+        *entry = gap_entry / fabsf(move);
+        *exit = gap_exit / fabsf(move);
+        return true;
+}
+
+// time of impact of r moving by move against target. rects that already overlap
+// do not count as a hit, hs_entity2_collide separates those
+hs_sweep2
+hs_rect2_sweep(const hs_rect2 r, const vec2 move, const hs_rect2 target)
+{
+        hs_sweep2 res = {0};
+
+        vec2 entry, exit;
+        if (!hs_rect2_sweep_axis(r.pos.x, r.half_size.x, move.x, target.pos.x, target.half_size.x, &entry.x, &exit.x) ||
+            !hs_rect2_sweep_axis(r.pos.y, r.half_size.y, move.y, target.pos.y, target.half_size.y, &entry.y, &exit.y))
+                return res;
+
+        const float time = max(entry.x, entry.y);
+        if (time < 0.0f || time > 1.0f || time >= min(exit.x, exit.y)) return res;
+
+        res.hit = true;
+        res.time = time;
+        if (entry.x > entry.y) res.normal.x = move.x > 0.0f ? -1 : 1;
+        else                   res.normal.y = move.y > 0.0f ? -1 : 1;
+        return res;
+}
+
+// moves e by move in one step, stopping at the first rect in the way and sliding along it.
+// returns how far e moved
+vec2
+hs_entity2_move_and_slide(hs_rect2* e, vec2 move, const hs_rect2* rects, const uint32_t rectc)
+{
+        const vec2 start = e->pos;
+
+        for (uint32_t i = 0; i < HS_SLIDE_ITERATIONS; i++) {
+                if (move.x == 0.0f && move.y == 0.0f) break;
+
+                hs_sweep2 first = {.time = INFINITY};
+                uint32_t first_rect = 0;
+                for (uint32_t j = 0; j < rectc; j++) {
+                        const hs_sweep2 sweep = hs_rect2_sweep(*e, move, rects[j]);
+                        if (sweep.hit && sweep.time < first.time) {
+                                first = sweep;
+                                first_rect = j;
+                        }
+                }
+
+                if (!first.hit) {
+                        e->pos = vec2_add(e->pos, move);
+                        break;
+                }
+
+                e->pos = vec2_add(e->pos, vec2_scale(move, first.time));
+                move = vec2_scale(move, 1.0f - first.time);
+
+                // snap onto the edge that was hit and drop the motion into it
+                const hs_rect2 hit = rects[first_rect];
+                if (first.normal.x) {
+                        e->pos.x = hit.pos.x + first.normal.x * (hit.half_size.x + e->half_size.x);
+                        move.x = 0.0f;
+                } else {
+                        e->pos.y = hit.pos.y + first.normal.y * (hit.half_size.y + e->half_size.y);
+                        move.y = 0.0f;
+                }
+        }
+
+        return vec2_sub(e->pos, start);
+}
+
 inline void
 hs_camera_move_front(hs_camera* camera, const float scale)
 {
@@ -1085,24 +2282,102 @@ void
 hs_tilemap_setall(hs_tilemap* tilemap, const uint32_t tile)
 {
         const uint32_t tilemap_size = tilemap->width * tilemap->height;
-        for(uint32_t v = 0; v < tilemap_size; v++)
-                hs_tilemap_set(tilemap, v, tile);
-}
+        if (tilemap_size == 0) return;
 
-inline void
-hs_tilemap_set_xy(hs_tilemap* tilemap, const uint32_t x, uint32_t y, uint32_t tile)
-{
-        hs_tilemap_set(tilemap, y * tilemap->width + x, tile);
+        // every square gets the same tex coords, compute them once and copy
+        hs_tilemap_set(tilemap, 0, tile);
+        const hs_tex_square first = tilemap->vertices[0];
+        for(uint32_t v = 1; v < tilemap_size; v++)
+                for (uint32_t c = 0; c < 6; c++)
+                        tilemap->vertices[v].c[c].tex = first.c[c].tex;
 }
 
-inline uint32_t
-hs_tilemap_sizeof(const hs_tilemap tilemap)
-{
-        return sizeof(hs_tex_square) * tilemap.width * tilemap.height;
+void
+hs_tileset_uv_init(hs_tileset_uv* uv, const uint32_t tileset_width, const uint32_t tileset_height)
+{
+        // go through hs_tilemap_set so the table matches it exactly, including the crop
+        hs_tex_square square;
+        hs_tilemap tilemap = {
+                .tileset_width = tileset_width,
+                .tileset_height = tileset_height,
+                .vertices = &square,
+        };
+
+        uv->tileset_width = tileset_width;
+        uv->tileset_height = tileset_height;
+        for (uint32_t t = 0; t < 256; t++) {
+                hs_tilemap_set(&tilemap, 0, t);
+                for (uint32_t c = 0; c < 6; c++)
+                        uv->tiles[t][c] = square.c[c].tex;
+        }
 }
 
-void
-hs_tilemap_init(hs_tilemap* tilemap, const uint32_t default_tex)
+// one table per tileset size, built on first use and kept for the program. the tables
+// never move or change, so returned pointers stay valid and can be read from any thread
+const hs_tileset_uv*
+hs_tileset_uv_get(const uint32_t tileset_width, const uint32_t tileset_height)
+{
+        static hs_dynarr tables = {0}; // hs_tileset_uv*
+#ifdef WIN32
+        static SRWLOCK lock = SRWLOCK_INIT;
+        AcquireSRWLockExclusive(&lock);
+#else
+        static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+        pthread_mutex_lock(&lock);
+#endif
+
+        hs_tileset_uv* uv = NULL;
+        for (size_t i = 0; i < tables.len && !uv; i++) {
+                hs_tileset_uv* t = hs_dynarr_idx(tables, hs_tileset_uv*, i);
+                if (t->tileset_width == tileset_width && t->tileset_height == tileset_height) uv = t;
+        }
+        if (!uv) {
+                if (!tables.data) tables = hs_dynarr_init(hs_tileset_uv*, 4);
+                uv = malloc(sizeof(hs_tileset_uv));
+                assert(uv);
+                hs_alloc_count++;
+                hs_tileset_uv_init(uv, tileset_width, tileset_height);
+                hs_dynarr_push(tables, hs_tileset_uv*, uv);
+        }
+
+#ifdef WIN32
+        ReleaseSRWLockExclusive(&lock);
+#else
+        pthread_mutex_unlock(&lock);
+#endif
+        return uv;
+}
+
+// tiles come straight from aroom bytes, each one is six 8 byte copies from the table
+inline void
+hs_tilemap_set_row(hs_tilemap* tilemap, const uint32_t vertex, const uint8_t* tiles, const uint32_t count, const hs_tileset_uv* uv)
+{
+        hs_tex_square* restrict dst = &tilemap->vertices[vertex];
+        for (uint32_t i = 0; i < count; i++) {
+                const vec2* restrict src = uv->tiles[tiles[i]];
+                dst[i].c[0].tex = src[0];
+                dst[i].c[1].tex = src[1];
+                dst[i].c[2].tex = src[2];
+                dst[i].c[3].tex = src[3];
+                dst[i].c[4].tex = src[4];
+                dst[i].c[5].tex = src[5];
+        }
+}
+
+inline void
+hs_tilemap_set_xy(hs_tilemap* tilemap, const uint32_t x, uint32_t y, uint32_t tile)
+{
+        hs_tilemap_set(tilemap, y * tilemap->width + x, tile);
+}
+
+inline uint32_t
+hs_tilemap_sizeof(const hs_tilemap tilemap)
+{
+        return sizeof(hs_tex_square) * tilemap.width * tilemap.height;
+}
+
+void
+hs_tilemap_init(hs_tilemap* tilemap, const uint32_t default_tex)
 {
         assert(tilemap->width);
         assert(tilemap->height);
@@ -1119,6 +2394,7 @@ hs_tilemap_init(hs_tilemap* tilemap, const uint32_t default_tex)
 
         tilemap->vertices = malloc(hs_tilemap_sizeof(*tilemap));
         assert(tilemap->vertices);
+        hs_alloc_count++;
 
         const float offset_x_default = -(float)tilemap->width * tilemap->tile_width + tilemap->tile_width;
         vec2 offset = {offset_x_default, -(float)tilemap->height * tilemap->tile_height + tilemap->tile_height};
@@ -1165,6 +2441,7 @@ hs_tilemap_update_vbo(const hs_tilemap tilemap)
 {
         glBindBuffer(GL_ARRAY_BUFFER, tilemap.sp.vobj.vbo);
         glBufferData(GL_ARRAY_BUFFER, hs_tilemap_sizeof(tilemap), castf(tilemap.vertices), GL_DYNAMIC_DRAW);
+        hs_stats.buffer_bytes += hs_tilemap_sizeof(tilemap);
 }
 
 inline void
@@ -1172,6 +2449,8 @@ hs_tilemap_draw(const hs_tilemap tilemap)
 {
         hs_sp_use(tilemap.sp);
         glDrawArrays(GL_TRIANGLES, 0, 6 * tilemap.width * tilemap.height);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6 * tilemap.width * tilemap.height;
 }
 
 inline void
@@ -1179,7 +2458,7 @@ hs_tilemap_free(hs_tilemap* tilemap)
 {
         free(tilemap->vertices);
         hs_sp_delete(tilemap->sp);
-        glDeleteTextures(1, &tilemap->tex);
+        hs_tex_delete(tilemap->tex);
 }
 
 inline void
@@ -1204,20 +2483,263 @@ hs_aroom_get_xy(const hs_aroom aroom, const uint16_t x, const uint16_t y)
         return aroom.data[x + y * aroom.width];
 }
 
+hs_tile_anim_table
+hs_tile_anim_table_create(const uint32_t tileset_width, const uint32_t tileset_height,
+                          const hs_tile_anim* anims, const uint32_t count)
+{
+        hs_tile_anim_table table = {
+                .tileset_width = tileset_width,
+                .tileset_height = tileset_height,
+        };
+        const uint32_t tiles = tileset_width * tileset_height;
+        assert(tiles);
+
+        uint32_t rows = 1;
+        for (uint32_t i = 0; i < count; i++)
+                rows = max(rows, 1u + anims[i].frame_count);
+
+        uint16_t* data = calloc((size_t)tiles * rows * 2, sizeof(uint16_t));
+        assert(data);
+        hs_alloc_count++;
+
+        for (uint32_t i = 0; i < count; i++) {
+                const hs_tile_anim* anim = &anims[i];
+                assert(anim->tile < tiles);
+                assert(anim->frame_count <= HS_TILE_ANIM_MAX_FRAMES);
+
+                uint32_t end_ms = 0;
+                for (uint32_t f = 0; f < anim->frame_count; f++) {
+                        assert(anim->frames[f] < tiles);
+                        end_ms += anim->frame_ms[f];
+                        data[((f + 1) * tiles + anim->tile) * 2 + 0] = anim->frames[f];
+                        data[((f + 1) * tiles + anim->tile) * 2 + 1] = end_ms;
+                }
+                if (anim->frame_count > 1 && (end_ms == 0 || end_ms > UINT16_MAX)) {
+                        fprintf(stderr, "---error tile %u animation lasts %u ms, must be 1 to 65535---\n",
+                                anim->tile, end_ms);
+                        assert(end_ms && end_ms <= UINT16_MAX);
+                }
+                data[anim->tile * 2 + 0] = anim->frame_count;
+                data[anim->tile * 2 + 1] = end_ms;
+        }
+
+        glGenTextures(1, &table.tex);
+        glBindTexture(GL_TEXTURE_2D, table.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16UI, tiles, rows, 0, GL_RG_INTEGER, GL_UNSIGNED_SHORT, data);
+        hs_stats_texture_set(table.tex, (uint64_t)tiles * rows * 4);
+
+        free(data);
+        return table;
+}
+
+inline void
+hs_tile_anim_table_free(hs_tile_anim_table* table)
+{
+        hs_tex_delete(table->tex);
+        table->tex = 0;
+}
+
+// the table goes in unit 1, the tileset stays in unit 0
+inline void
+hs_tile_anim_activate(const hs_tile_anim_table table)
+{
+        hs_tex2d_activate(table.tex, GL_TEXTURE1);
+        glActiveTexture(GL_TEXTURE0);
+}
+
+// swaps the program for one built from v_src and f_src, the values of the coord uniforms
+// carry over so the map stays where it was. the program is left in use
+static void
+hs_sp_replace(hs_shader_program* sp, const char* v_src, const char* f_src)
+{
+        vec2 model = {0}, view = {0};
+        mat4 proj = MAT4_IDENTITY;
+        if (sp->p) {
+                if ((int32_t)sp->coord.model >= 0) glGetUniformfv(sp->p, sp->coord.model, model.xy);
+                if ((int32_t)sp->coord.view  >= 0) glGetUniformfv(sp->p, sp->coord.view, view.xy);
+                if ((int32_t)sp->coord.proj  >= 0) glGetUniformfv(sp->p, sp->coord.proj, proj[0]);
+                glDeleteProgram(sp->p);
+        }
+
+        sp->p = hs_sp_create_from_src(v_src, f_src);
+        sp->coord = hs_uniform_coord_create(sp->p, "u_model", "u_view", "u_proj");
+        hs_uniform_vec2_set(sp->coord.model, model);
+        hs_uniform_vec2_set(sp->coord.view, view);
+        hs_uniform_mat4_set(sp->coord.proj, proj);
+}
+
+// replaces the program of a hs_tilemap or hs_dyn_tilemap with the animated one,
+// the vertex layout and the coord uniforms stay the same. returns the u_time uniform
+uint32_t
+hs_tile_anim_sp_set(hs_shader_program* sp, const hs_tile_anim_table table)
+{
+        hs_sp_replace(sp, tile_anim_vert, texture_transform_frag);
+
+        hs_tex_uniform_set(hs_uniform_create(sp->p, "u_tex"), 0);
+        hs_tex_uniform_set(hs_uniform_create(sp->p, "u_anim"), 1);
+        hs_uniform_vec2_set(hs_uniform_create(sp->p, "u_tileset_size"),
+                            (vec2){table.tileset_width, table.tileset_height});
+        return hs_uniform_create(sp->p, "u_time");
+}
+
+// usually hs_time_ns() / 1000000, wraps after 49 days. the animated program has to be
+// in use, hs_sp_use(tilemap.sp) before it and hs_tilemap_draw binds the same one again
+inline void
+hs_tile_anim_time_set(const uint32_t u_time, const uint32_t ms)
+{
+        glUniform1ui(u_time, ms);
+}
+
+static inline void
+hs_fog_dirty_clear(hs_fog* fog)
+{
+        fog->dirty = (hs_aabb2i){.bl = {INT32_MAX, INT32_MAX}, .tr = {INT32_MIN, INT32_MIN}};
+}
+
+hs_fog
+hs_fog_create(const uint32_t width, const uint32_t height, const uint8_t value, const GLenum filter)
+{
+        hs_fog fog = {.width = width, .height = height};
+        fog.cells = malloc((size_t)width * height);
+        assert(fog.cells);
+        hs_alloc_count++;
+        memset(fog.cells, value, (size_t)width * height);
+        hs_fog_dirty_clear(&fog);
+        fog.lit = fog.dirty;
+
+        glGenTextures(1, &fog.tex);
+        glBindTexture(GL_TEXTURE_2D, fog.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, fog.cells);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        hs_stats_texture_set(fog.tex, (uint64_t)width * height);
+        return fog;
+}
+
+inline void
+hs_fog_free(hs_fog* fog)
+{
+        hs_tex_delete(fog->tex);
+        free(fog->cells);
+        fog->tex = 0;
+        fog->cells = NULL;
+}
+
+// only marks the cell when the value changes
+inline void
+hs_fog_set(hs_fog* fog, const uint32_t x, const uint32_t y, const uint8_t value)
+{
+        assert(x < fog->width && y < fog->height);
+        uint8_t* cell = &fog->cells[x + y * fog->width];
+        if (*cell == value) return;
+        *cell = value;
+
+        fog->dirty.bl.x = min(fog->dirty.bl.x, (int32_t)x);
+        fog->dirty.bl.y = min(fog->dirty.bl.y, (int32_t)y);
+        fog->dirty.tr.x = max(fog->dirty.tr.x, (int32_t)x);
+        fog->dirty.tr.y = max(fog->dirty.tr.y, (int32_t)y);
+}
+
+inline uint8_t
+hs_fog_get(const hs_fog fog, const uint32_t x, const uint32_t y)
+{
+        return fog.cells[x + y * fog.width];
+}
+
+// one glTexSubImage2D of the rect that changed since the last call, nothing when no cell did
+void
+hs_fog_upload(hs_fog* fog)
+{
+        if (fog->dirty.bl.x > fog->dirty.tr.x) return;
+
+        const hs_aabb2i d = fog->dirty;
+        glBindTexture(GL_TEXTURE_2D, fog->tex);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, fog->width);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, d.bl.x, d.bl.y, d.tr.x - d.bl.x + 1, d.tr.y - d.bl.y + 1,
+                        GL_RED, GL_UNSIGNED_BYTE, fog->cells + d.bl.x + (size_t)d.bl.y * fog->width);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        hs_fog_dirty_clear(fog);
+}
+
+// the fog goes in unit 2, next to the tileset in unit 0 and tile animations in unit 1
+inline void
+hs_fog_activate(const hs_fog fog)
+{
+        hs_tex2d_activate(fog.tex, GL_TEXTURE2);
+        glActiveTexture(GL_TEXTURE0);
+}
+
+// replaces the program with the fogged one. origin is the bottom left corner of tile (0, 0)
+// in model space and tile_size the size of one tile, like hs_grid
+void
+hs_fog_sp_set(hs_shader_program* sp, const vec2 origin, const vec2 tile_size, const hs_fog fog)
+{
+        hs_sp_replace(sp, fog_transform_vert, fog_transform_frag);
+
+        hs_tex_uniform_set(hs_uniform_create(sp->p, "u_tex"), 0);
+        hs_tex_uniform_set(hs_uniform_create(sp->p, "u_fog"), 2);
+        hs_uniform_vec2_set(hs_uniform_create(sp->p, "u_fog_origin"), origin);
+        hs_uniform_vec2_set(hs_uniform_create(sp->p, "u_fog_scale"),
+                            (vec2){1.0f / (tile_size.x * fog.width), 1.0f / (tile_size.y * fog.height)});
+}
+
+// hs_tilemap is centered on the origin, fog cell (x, y) covers tile (x, y)
+inline void
+hs_fog_tilemap_sp_set(hs_tilemap* tilemap, const hs_fog fog)
+{
+        hs_fog_sp_set(&tilemap->sp,
+                      (vec2){-(float)tilemap->width * tilemap->tile_width, -(float)tilemap->height * tilemap->tile_height},
+                      (vec2){tilemap->tile_width * 2.0f, tilemap->tile_height * 2.0f}, fog);
+}
+
 void
 hs_aroom_set_tilemap(const hs_aroom aroom, hs_tilemap* tilemap, const uint16_t layer)
 {
         assert(tilemap->width  == aroom.width);
         assert(tilemap->height == aroom.height);
 
-        if (layer > 1) {
-                const uint32_t offset = (aroom.width * aroom.height * layer) - (aroom.width * aroom.height);
-                for(uint32_t i = 0; i < aroom.width * aroom.height; i++)
-                        hs_tilemap_set(tilemap, i, aroom.data[i + offset]);
-        } else {
-                for(uint32_t i = 0; i < aroom.width * aroom.height; i++)
-                        hs_tilemap_set(tilemap, i, aroom.data[i]);
-        }
+        const hs_tileset_uv* uv = hs_tileset_uv_get(tilemap->tileset_width, tilemap->tileset_height);
+        hs_tilemap_set_row(tilemap, 0, hs_aroom_layer(aroom, layer), aroom.width * aroom.height, uv);
+        hs_tilemap_update_vbo(*tilemap);
+}
+
+typedef struct {
+        const uint8_t* tiles;
+        hs_tilemap* tilemap;
+        const hs_tileset_uv* uv;
+} hs_aroom_set_tilemap_job;
+
+static void
+hs_aroom_set_tilemap_rows(void* data, const uint32_t begin, const uint32_t end)
+{
+        hs_aroom_set_tilemap_job* job = data;
+        const uint32_t width = job->tilemap->width;
+        hs_tilemap_set_row(job->tilemap, begin * width, job->tiles + begin * width, (end - begin) * width, job->uv);
+}
+
+// splits the rows between threads, only worth it on maps in the millions of tiles
+void
+hs_aroom_set_tilemap_mt(const hs_aroom aroom, hs_tilemap* tilemap, const uint16_t layer, const uint32_t threads)
+{
+        assert(tilemap->width  == aroom.width);
+        assert(tilemap->height == aroom.height);
+
+        hs_aroom_set_tilemap_job job = {
+                .tiles = hs_aroom_layer(aroom, layer),
+                .tilemap = tilemap,
+                .uv = hs_tileset_uv_get(tilemap->tileset_width, tilemap->tileset_height),
+        };
+        hs_parallel_for(aroom.height, threads, hs_aroom_set_tilemap_rows, &job);
         hs_tilemap_update_vbo(*tilemap);
 }
 
@@ -1227,18 +2749,19 @@ hs_aroom_set_tilemap_offsetv(const hs_aroom aroom, hs_tilemap* tilemap, const ui
         assert(tilemap->width  >= offset.x + aroom.width);
         assert(tilemap->height >= offset.y + aroom.height);
 
-        if (layer > 1) {
-                const uint32_t layer_offset = (aroom.width * aroom.height * layer) - (aroom.width * aroom.height);
-                uint32_t i = 0;
-                for(uint32_t x = offset.x; x < aroom.width; x++)
-                        for(uint32_t y = offset.y; y < aroom.height; y++)
-                                hs_tilemap_set_xy(tilemap, x, y, aroom.data[layer_offset + i++]);
-        } else {
-                uint32_t i = 0;
-                for(uint32_t x = offset.x; x < offset.x + aroom.width; x++)
-                        for(uint32_t y = offset.y; y < offset.y + aroom.height; y++)
-                                hs_tilemap_set_xy(tilemap, x, y, aroom.data[i++]);
-        }
+        const hs_tileset_uv* uv = hs_tileset_uv_get(tilemap->tileset_width, tilemap->tileset_height);
+        const uint8_t* tiles = hs_aroom_layer(aroom, layer);
+        for(uint32_t y = 0; y < aroom.height; y++)
+                hs_tilemap_set_row(tilemap, (offset.y + y) * tilemap->width + offset.x,
+                                   tiles + y * aroom.width, aroom.width, uv);
+}
+
+// layers start at 1, 0 is treated as 1
+inline uint8_t*
+hs_aroom_layer(const hs_aroom aroom, const uint16_t layer)
+{
+        if (layer <= 1) return aroom.data;
+        return aroom.data + (uint32_t)aroom.width * aroom.height * (layer - 1);
 }
 
 vec2
@@ -1253,44 +2776,107 @@ hs_tilemap_pos_to_global(const hs_tilemap tilemap, vec2i pos)
 uint32_t
 hs_dyn_tilemap_sizeof(const hs_dyn_tilemap tilemap)
 {
-        return sizeof(hs_tex_square) * tilemap.vertices.len;
+        return (tilemap.compact ? sizeof(hs_tex_square16) : sizeof(hs_tex_square)) * tilemap.vertices.len;
 }
 
-void
-hs_dyn_tilemap_init(hs_dyn_tilemap* tilemap, size_t size)
+static void
+hs_dyn_tilemap_defaults(hs_dyn_tilemap* tilemap, size_t* size)
 {
         if (tilemap->tile_height    <= 0.0f) tilemap->tile_height = 0.1f;
         if (tilemap->tile_width     <= 0.0f) tilemap->tile_width = 0.1f;
         if (tilemap->tileset_height == 0)    tilemap->tileset_height = 1;
         if (tilemap->tileset_width  == 0)    tilemap->tileset_width = 1;
         if (tilemap->tex            == 0)    tilemap->tex = hs_default_missing_tex;
-        if (size                    == 0)    size = 10000;
-
-        tilemap->vertices = hs_dynarr_init(hs_tex_square, size);
+        if (*size                   == 0)    *size = 10000;
+}
 
-        hs_vobj vobj = hs_vobj_create(castf(tilemap->vertices.data), hs_dyn_tilemap_sizeof(*tilemap), 0, 0, GL_DYNAMIC_DRAW, 1);
-        tilemap->sp = hs_shader_program_create(hs_sp_texture_transform_create(), vobj);
+// the vao and vbo of vobj have to be bound
+static void
+hs_dyn_tilemap_sp_create(hs_dyn_tilemap* tilemap, const hs_vobj vobj)
+{
+        if (tilemap->compact) {
+                tilemap->sp = hs_shader_program_create(hs_sp_create_from_src(compact_transform_vert, texture_transform_frag), vobj);
+                // corners sit on half tiles
+                hs_uniform_vec2_set(hs_uniform_create(tilemap->sp.p, "u_scale"),
+                                    (vec2){tilemap->tile_width, tilemap->tile_height});
+        } else {
+                tilemap->sp = hs_shader_program_create(hs_sp_texture_transform_create(), vobj);
+        }
 
         hs_tex_uniform_set(hs_uniform_create(tilemap->sp.p, "u_tex"), 0);
         tilemap->sp.coord = hs_uniform_coord_create(tilemap->sp.p, "u_model", "u_view", "u_proj");
         hs_uniform_mat4_set(tilemap->sp.coord.proj, (mat4)MAT4_IDENTITY);
 
-        hs_vattrib_enable_float(0, 2, 4, 0);
-        hs_vattrib_enable_float(1, 2, 4, 2);
+        if (tilemap->compact) {
+                hs_vattrib_enable_int(0, 2, GL_SHORT, sizeof(hs_tex_corner16), 0);
+                hs_vattrib_enable_norm(1, 2, GL_UNSIGNED_SHORT, sizeof(hs_tex_corner16), offsetof(hs_tex_corner16, tex));
+        } else {
+                hs_vattrib_enable_float(0, 2, 4, 0);
+                hs_vattrib_enable_float(1, 2, 4, 2);
+        }
+}
+
+void
+hs_dyn_tilemap_init(hs_dyn_tilemap* tilemap, size_t size)
+{
+        hs_dyn_tilemap_defaults(tilemap, &size);
+        tilemap->vertices = tilemap->compact ? hs_dynarr_init(hs_tex_square16, size) : hs_dynarr_init(hs_tex_square, size);
+        tilemap->stream = NULL;
+
+        hs_vobj vobj = hs_vobj_create(castf(tilemap->vertices.data), hs_dyn_tilemap_sizeof(*tilemap), 0, 0, GL_DYNAMIC_DRAW, 1);
+        hs_dyn_tilemap_sp_create(tilemap, vobj);
+}
+
+// squares are written straight into a hs_stream_buffer, size is the most squares
+// pushed between two clears. clear starts a new section, so call it once per frame
+void
+hs_dyn_tilemap_init_stream(hs_dyn_tilemap* tilemap, size_t size)
+{
+        hs_dyn_tilemap_defaults(tilemap, &size);
+        tilemap->vertices = (hs_dynarr){.cap = size};
+
+        tilemap->stream = malloc(sizeof(hs_stream_buffer));
+        assert(tilemap->stream);
+        hs_alloc_count++;
+
+        hs_vobj vobj = {.count = 1};
+        vobj.vao = hs_vao_create(1);
+        if (tilemap->compact)
+                hs_stream_buffer_init(tilemap->stream, sizeof(hs_tex_square16) * size, sizeof(hs_tex_corner16));
+        else
+                hs_stream_buffer_init(tilemap->stream, sizeof(hs_tex_square) * size, sizeof(hs_tex_corner));
+        vobj.vbo = tilemap->stream->vbo;
+        hs_dyn_tilemap_sp_create(tilemap, vobj);
+
+        hs_stream_buffer_begin(tilemap->stream, tilemap->stream->size);
 }
 
 inline void
 hs_dyn_tilemap_clear(hs_dyn_tilemap* tilemap)
 {
         hs_dynarr_clear(tilemap->vertices);
+
+        if (tilemap->stream) {
+                if (tilemap->stream->write) hs_stream_buffer_end(tilemap->stream, 0);
+                hs_stream_buffer_frame_end(tilemap->stream);
+                hs_stream_buffer_begin(tilemap->stream, tilemap->stream->size);
+        }
 }
 
 inline void
 hs_dyn_tilemap_free(hs_dyn_tilemap* tilemap)
 {
-        hs_dynarr_free(tilemap->vertices);
+        if (tilemap->stream) {
+                hs_stream_buffer_free(tilemap->stream);
+                free(tilemap->stream);
+                tilemap->stream = NULL;
+                tilemap->sp.vobj.vbo = 0;
+                tilemap->vertices = (hs_dynarr){0};
+        } else {
+                hs_dynarr_free(tilemap->vertices);
+        }
         hs_sp_delete(tilemap->sp);
-        glDeleteTextures(1, &tilemap->tex);
+        hs_tex_delete(tilemap->tex);
 }
 
 void
@@ -1321,21 +2907,53 @@ hs_dyn_tilemap_push(hs_dyn_tilemap* tilemap, const vec2i pos, uint32_t tile)
         square_pos.tr.y = offset.y + tilemap->tile_height;
         hs_tex_square_set_pos(&new_tile, square_pos);
 
-        hs_dynarr_push(tilemap->vertices, hs_tex_square, new_tile);
+        if (tilemap->compact) {
+                assert(abs(pos.x) < 16384 && abs(pos.y) < 16384);
+                hs_tex_square16 new_tile16;
+                for (uint32_t c = 0; c < 6; c++) {
+                        // back to half tiles, exact up to float rounding
+                        new_tile16.c[c].pos[0] = lroundf(new_tile.c[c].pos.x / tilemap->tile_width);
+                        new_tile16.c[c].pos[1] = lroundf(new_tile.c[c].pos.y / tilemap->tile_height);
+                        new_tile16.c[c].tex[0] = new_tile.c[c].tex.x * UINT16_MAX + 0.5f;
+                        new_tile16.c[c].tex[1] = new_tile.c[c].tex.y * UINT16_MAX + 0.5f;
+                }
+
+                if (tilemap->stream) {
+                        assert(tilemap->stream->write);
+                        assert(tilemap->vertices.len < tilemap->vertices.cap);
+                        ((hs_tex_square16*)tilemap->stream->write)[tilemap->vertices.len++] = new_tile16;
+                } else {
+                        hs_dynarr_push(tilemap->vertices, hs_tex_square16, new_tile16);
+                }
+        } else if (tilemap->stream) {
+                assert(tilemap->stream->write);
+                assert(tilemap->vertices.len < tilemap->vertices.cap);
+                ((hs_tex_square*)tilemap->stream->write)[tilemap->vertices.len++] = new_tile;
+        } else {
+                hs_dynarr_push(tilemap->vertices, hs_tex_square, new_tile);
+        }
 }
 
 void
 hs_dyn_tilemap_update_vbo(const hs_dyn_tilemap tilemap)
 {
+        if (tilemap.stream) {
+                hs_stream_buffer_end(tilemap.stream, hs_dyn_tilemap_sizeof(tilemap));
+                return;
+        }
+
         glBindBuffer(GL_ARRAY_BUFFER, tilemap.sp.vobj.vbo);
         glBufferData(GL_ARRAY_BUFFER, hs_dyn_tilemap_sizeof(tilemap), castf(tilemap.vertices.data), GL_DYNAMIC_DRAW);
+        hs_stats.buffer_bytes += hs_dyn_tilemap_sizeof(tilemap);
 }
 
 inline void
 hs_dyn_tilemap_draw(const hs_dyn_tilemap tilemap)
 {
         hs_sp_use(tilemap.sp);
-        glDrawArrays(GL_TRIANGLES, 0, 6 * tilemap.vertices.len);
+        glDrawArrays(GL_TRIANGLES, tilemap.stream ? tilemap.stream->first : 0, 6 * tilemap.vertices.len);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6 * tilemap.vertices.len;
 }
 
 void
@@ -1358,6 +2976,133 @@ hs_aroom_push_dyn_tilemap(const hs_aroom aroom, hs_dyn_tilemap* tilemap, const u
         }
 }
 
+inline uint32_t
+hs_layered_tilemap_sizeof(const hs_layered_tilemap tilemap)
+{
+        return sizeof(hs_tex_layer_square) * tilemap.square_count;
+}
+
+// width, height and layers have to be set, hs_aroom_to_layered_tilemap does it from the aroom
+void
+hs_layered_tilemap_init(hs_layered_tilemap* tilemap)
+{
+        assert(tilemap->width);
+        assert(tilemap->height);
+        assert(tilemap->layers <= HS_LAYERED_TILEMAP_MAX_LAYERS);
+        if (tilemap->layers == 0)          tilemap->layers = 1;
+        if (tilemap->tile_width <= 0.0f)   tilemap->tile_width = 1.0f/tilemap->width;
+        if (tilemap->tile_height <= 0.0f)  tilemap->tile_height = 1.0f/tilemap->height;
+        if (tilemap->tileset_width == 0)   tilemap->tileset_width = 1;
+        if (tilemap->tileset_height == 0)  tilemap->tileset_height = 1;
+        if (tilemap->tex == 0)
+                tilemap->tex = hs_tex2d_array_create_data(hs_default_missing_tex_data, 32, 32, 1,
+                                                          GL_RGBA, GL_REPEAT, GL_NEAREST);
+
+        free(tilemap->vertices);
+        tilemap->vertices = malloc(sizeof(hs_tex_layer_square) * tilemap->width * tilemap->height * tilemap->layers);
+        assert(tilemap->vertices);
+        hs_alloc_count++;
+        tilemap->square_count = 0;
+
+        if (!tilemap->sp.p) {
+                hs_vobj vobj = hs_vobj_create(NULL, 0, 0, 0, GL_DYNAMIC_DRAW, 1);
+                tilemap->sp = hs_shader_program_create(hs_sp_create_from_src(layered_tilemap_vert, layered_tilemap_frag), vobj);
+
+                hs_tex_uniform_set(hs_uniform_create(tilemap->sp.p, "u_tex"), 0);
+                tilemap->sp.coord = hs_uniform_coord_create(tilemap->sp.p, "u_model", "u_view", "u_proj");
+                hs_uniform_mat4_set(tilemap->sp.coord.proj, (mat4)MAT4_IDENTITY);
+
+                hs_vattrib_enable_float(0, 3, 6, 0);
+                hs_vattrib_enable_float(1, 3, 6, 3);
+        }
+}
+
+inline void
+hs_layered_tilemap_update_vbo(const hs_layered_tilemap tilemap)
+{
+        glBindBuffer(GL_ARRAY_BUFFER, tilemap.sp.vobj.vbo);
+        glBufferData(GL_ARRAY_BUFFER, hs_layered_tilemap_sizeof(tilemap), castf(tilemap.vertices), GL_DYNAMIC_DRAW);
+        hs_stats.buffer_bytes += hs_layered_tilemap_sizeof(tilemap);
+}
+
+// the texture array has to be bound to unit 0, like hs_tilemap_draw
+inline void
+hs_layered_tilemap_draw(const hs_layered_tilemap tilemap)
+{
+        hs_sp_use(tilemap.sp);
+        glDrawArrays(GL_TRIANGLES, 0, 6 * tilemap.square_count);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6 * tilemap.square_count;
+}
+
+inline void
+hs_layered_tilemap_free(hs_layered_tilemap* tilemap)
+{
+        free(tilemap->vertices);
+        tilemap->vertices = NULL;
+        hs_sp_delete(tilemap->sp);
+        hs_tex_delete(tilemap->tex);
+}
+
+void
+hs_aroom_to_layered_tilemap(const hs_aroom aroom, hs_layered_tilemap* tilemap)
+{
+        tilemap->width = aroom.width;
+        tilemap->height = aroom.height;
+        tilemap->layers = aroom.layers == 0 ? 1 : aroom.layers;
+        hs_layered_tilemap_init(tilemap);
+
+        hs_aroom_set_layered_tilemap(aroom, tilemap);
+}
+
+void
+hs_aroom_set_layered_tilemap(const hs_aroom aroom, hs_layered_tilemap* tilemap)
+{
+        assert(tilemap->width  == aroom.width);
+        assert(tilemap->height == aroom.height);
+        assert(tilemap->layers <= (aroom.layers == 0 ? 1 : aroom.layers));
+
+        const hs_tileset_uv* uv = hs_tileset_uv_get(tilemap->tileset_width, tilemap->tileset_height);
+        const float offset_x = -(float)tilemap->width * tilemap->tile_width + tilemap->tile_width;
+        const float offset_y = -(float)tilemap->height * tilemap->tile_height + tilemap->tile_height;
+        hs_tex_layer_square* square = tilemap->vertices;
+
+        for (uint32_t l = 0; l < tilemap->layers; l++) {
+                const uint8_t* tiles = hs_aroom_layer(aroom, l + 1);
+                const float depth = -(float)l / HS_LAYERED_TILEMAP_MAX_LAYERS;
+                const float slice = tilemap->tileset[l];
+                const bool skip = tilemap->skip_empty && l > 0;
+
+                for (uint32_t y = 0; y < tilemap->height; y++) {
+                        const float center_y = offset_y + y * tilemap->tile_height * 2.0f;
+                        const float bl_y = center_y - tilemap->tile_height;
+                        const float tr_y = center_y + tilemap->tile_height;
+
+                        for (uint32_t x = 0; x < tilemap->width; x++) {
+                                const uint8_t tile = tiles[x + y * tilemap->width];
+                                if (skip && tile == 0) continue;
+
+                                const float center_x = offset_x + x * tilemap->tile_width * 2.0f;
+                                const float bl_x = center_x - tilemap->tile_width;
+                                const float tr_x = center_x + tilemap->tile_width;
+                                const vec2* tex = uv->tiles[tile];
+
+                                // same corner order as hs_tex_square_set_pos
+                                square->c[0] = (hs_tex_layer_corner){{bl_x, bl_y}, depth, tex[0], slice};
+                                square->c[1] = (hs_tex_layer_corner){{tr_x, bl_y}, depth, tex[1], slice};
+                                square->c[2] = (hs_tex_layer_corner){{tr_x, tr_y}, depth, tex[2], slice};
+                                square->c[3] = (hs_tex_layer_corner){{tr_x, tr_y}, depth, tex[3], slice};
+                                square->c[4] = (hs_tex_layer_corner){{bl_x, tr_y}, depth, tex[4], slice};
+                                square->c[5] = (hs_tex_layer_corner){{bl_x, bl_y}, depth, tex[5], slice};
+                                square++;
+                        }
+                }
+        }
+
+        tilemap->square_count = square - tilemap->vertices;
+        hs_layered_tilemap_update_vbo(*tilemap);
+}
+
 vec2
 hs_dyn_tilemap_pos_to_global(const hs_dyn_tilemap tilemap, vec2i pos)
 {
@@ -1384,10 +3129,37 @@ hs_sp_sprite_create(const float width, const float height, const float screen_si
         return sp;
 }
 
+// same square as hs_sp_sprite_create in 8 byte vertices, scaled in the shader
+inline hs_shader_program
+hs_sp_sprite_create_compact(const float width, const float height, const float screen_size)
+{
+        const hs_tex_corner16 vertices[] = {
+                {{ 1,  1}, {UINT16_MAX, 0}},
+                {{ 1, -1}, {UINT16_MAX, UINT16_MAX}},
+                {{-1,  1}, {0, 0}},
+                {{ 1, -1}, {UINT16_MAX, UINT16_MAX}},
+                {{-1, -1}, {0, UINT16_MAX}},
+                {{-1,  1}, {0, 0}},
+        };
+
+        hs_vobj vobj = hs_vobj_create((const float*)vertices, sizeof(vertices), 0, 0, GL_STATIC_DRAW, 1);
+        hs_shader_program sp = hs_shader_program_create(hs_sp_create_from_src(compact_transform_vert, texture_transform_frag), vobj);
+        sp.coord = hs_uniform_coord_create(sp.p, "u_model", "u_view", "u_proj");
+        hs_uniform_mat4_set(sp.coord.proj, (mat4)MAT4_IDENTITY);
+        hs_uniform_vec2_set(hs_uniform_create(sp.p, "u_scale"), (vec2){width/screen_size, width/screen_size});
+
+        hs_vattrib_enable_int(0, 2, GL_SHORT, sizeof(hs_tex_corner16), 0);
+        hs_vattrib_enable_norm(1, 2, GL_UNSIGNED_SHORT, sizeof(hs_tex_corner16), offsetof(hs_tex_corner16, tex));
+
+        return sp;
+}
+
 inline void
 hs_sprite_draw_current()
 {
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6;
 }
 
 inline hs_entity2
@@ -1414,6 +3186,7 @@ hs_vbo_create(const float *vbuff, const uint32_t buffsize, const GLenum usage, c
         glGenBuffers(count, &vbo);
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
         glBufferData(GL_ARRAY_BUFFER, buffsize, vbuff, usage);
+        hs_stats.buffer_bytes += buffsize;
         return vbo;
 }
 
@@ -1425,6 +3198,7 @@ hs_ebo_create(const uint32_t *ibuff, const uint32_t buffsize, const GLenum usage
         glGenBuffers(1, &ebo);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffsize, ibuff, usage);
+        hs_stats.buffer_bytes += buffsize;
         return ebo;
 }
 
@@ -1450,6 +3224,109 @@ hs_vobj_free(hs_vobj vobj)
         glDeleteBuffers(vobj.count, &vobj.vbo);
 }
 
+// leaves the buffer bound to GL_ARRAY_BUFFER for the vertex attributes
+void
+hs_stream_buffer_init(hs_stream_buffer* sb, const uint32_t size, const uint32_t stride)
+{
+        assert(stride);
+        *sb = (hs_stream_buffer){
+                .size = (size + stride - 1) / stride * stride,
+                .stride = stride,
+                .persistent = GLAD_GL_VERSION_4_4,
+        };
+
+        glGenBuffers(1, &sb->vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, sb->vbo);
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        if (sb->persistent) {
+                glBufferStorage(GL_ARRAY_BUFFER, sb->size * HS_STREAM_FRAMES, NULL, flags);
+                sb->mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, sb->size * HS_STREAM_FRAMES, flags);
+                assert(sb->mapped);
+        } else {
+                glBufferData(GL_ARRAY_BUFFER, sb->size * HS_STREAM_FRAMES, NULL, GL_STREAM_DRAW);
+        }
+        hs_stats.buffer_bytes += sb->size * HS_STREAM_FRAMES;
+}
+
+// reserves up to max_bytes in the current section, nothing else may map the buffer until end
+void*
+hs_stream_buffer_begin(hs_stream_buffer* sb, const uint32_t max_bytes)
+{
+        assert(!sb->write);
+        sb->offset = (sb->offset + sb->stride - 1) / sb->stride * sb->stride;
+        if (sb->offset + max_bytes > sb->size) {
+                fprintf(stderr, "---error stream buffer section is %u bytes, %u are in use and %u more were asked for---\n",
+                        sb->size, sb->offset, max_bytes);
+                assert(sb->offset + max_bytes <= sb->size);
+        }
+
+        sb->begin = sb->frame * sb->size + sb->offset;
+        if (sb->persistent) {
+                sb->write = sb->mapped + sb->begin;
+        } else {
+                // the fences already keep this range away from the gpu
+                glBindBuffer(GL_ARRAY_BUFFER, sb->vbo);
+                sb->write = glMapBufferRange(GL_ARRAY_BUFFER, sb->begin, max_bytes,
+                                             GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                             GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+                assert(sb->write);
+        }
+        return sb->write;
+}
+
+// bytes is how much of the reservation was written, returns the first vertex of the write
+uint32_t
+hs_stream_buffer_end(hs_stream_buffer* sb, const uint32_t bytes)
+{
+        assert(sb->write);
+        if (!sb->persistent) {
+                glBindBuffer(GL_ARRAY_BUFFER, sb->vbo);
+                if (bytes) glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, bytes);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+
+        sb->write = NULL;
+        sb->offset += bytes;
+        sb->first = sb->begin / sb->stride;
+        hs_stats.buffer_bytes += bytes;
+#ifdef HS_GL_STATS
+        hs_gl_stats_buffer_write(sb->vbo, bytes);
+#endif
+        return sb->first;
+}
+
+// after the last draw reading this section, waits if the gpu is still on the next one
+void
+hs_stream_buffer_frame_end(hs_stream_buffer* sb)
+{
+        assert(!sb->write);
+        if (sb->fences[sb->frame]) glDeleteSync(sb->fences[sb->frame]);
+        sb->fences[sb->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        sb->frame = (sb->frame + 1) % HS_STREAM_FRAMES;
+        sb->offset = 0;
+
+        GLsync fence = sb->fences[sb->frame];
+        if (fence) {
+                while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+                glDeleteSync(fence);
+                sb->fences[sb->frame] = NULL;
+        }
+}
+
+void
+hs_stream_buffer_free(hs_stream_buffer* sb)
+{
+        for (uint32_t i = 0; i < HS_STREAM_FRAMES; i++)
+                if (sb->fences[i]) glDeleteSync(sb->fences[i]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, sb->vbo);
+        if (sb->persistent || sb->write) glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &sb->vbo);
+        *sb = (hs_stream_buffer){0};
+}
+
 inline void
 hs_fps_callback_init(const hs_game_data gd, void(*mouse_callback)(GLFWwindow*, double xpos, double ypos))
 {
@@ -1463,13 +3340,6 @@ hs_disable_vsync()
         glfwSwapInterval(0);
 }
 
-enum hs_init_flags {
-        HS_NO_VSYNC = 1 << 0,
-        HS_WIREFRAME_MODE = 1 << 1,
-        HS_BLEND_MODE = 1 << 2,
-        HS_DEPTH_TESTING = 1 << 3,
-};
-
 inline static void
 hs_init(hs_game_data* gd, const char *name, void(*framebuffer_size_callback)(GLFWwindow*, int, int), const uint32_t flags)
 {
@@ -1478,6 +3348,11 @@ hs_init(hs_game_data* gd, const char *name, void(*framebuffer_size_callback)(GLF
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+        if (flags & HS_HEADLESS) {
+                glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+                glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        }
+
         if (!gd->width) gd->width = 800;
         if (!gd->height) gd->height = 600;
 
@@ -1486,6 +3361,9 @@ hs_init(hs_game_data* gd, const char *name, void(*framebuffer_size_callback)(GLF
 
         glfwMakeContextCurrent(window);
         assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress));
+#ifdef HS_GL_STATS
+        hs_gl_stats_hook();
+#endif
         glViewport(0, 0, gd->width, gd->height);
 
 #ifndef NO_STBI
@@ -1500,6 +3378,7 @@ hs_init(hs_game_data* gd, const char *name, void(*framebuffer_size_callback)(GLF
 
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 32, 32, 0, GL_RGBA, GL_UNSIGNED_BYTE, hs_default_missing_tex_data);
                 glGenerateMipmap(GL_TEXTURE_2D);
+                hs_stats_texture_set(hs_default_missing_tex, 32 * 32 * 4 * 4 / 3);
         }
 #endif // NO_STBI
 
@@ -1527,10 +3406,75 @@ hs_poll_input()
         glfwPollEvents();
 }
 
+inline void
+hs_stats_entities_set(const uint32_t entities)
+{
+        hs_stats.entities = entities;
+}
+
+// the size of tex replaces whatever was recorded for it before, 0 once it is deleted
+void
+hs_stats_texture_set(const uint32_t tex, const uint64_t bytes)
+{
+        if (!hs_stats_texture_sizes.data) {
+                hs_stats_texture_sizes = hs_dynarr_init(uint64_t, 64);
+                hs_dynarr_zero(hs_stats_texture_sizes, uint64_t);
+        }
+        if (tex >= hs_stats_texture_sizes.cap) {
+                const size_t old_cap = hs_stats_texture_sizes.cap;
+                hs_dynarr_resize(hs_stats_texture_sizes, uint64_t, max(old_cap * 2, tex + 1));
+                memset(hs_dynarr_data(hs_stats_texture_sizes, uint64_t) + old_cap, 0,
+                       sizeof(uint64_t) * (hs_stats_texture_sizes.cap - old_cap));
+        }
+
+        uint64_t* size = &hs_dynarr_idx(hs_stats_texture_sizes, uint64_t, tex);
+        hs_stats.texture_bytes = hs_stats.texture_bytes - *size + bytes;
+        *size = bytes;
+}
+
+inline hs_frame_stats
+hs_stats_last_frame()
+{
+        return hs_stats_last;
+}
+
+void
+hs_stats_frame_end()
+{
+        static uint64_t last_frame = 0;
+        const uint64_t current_frame = hs_time_ns();
+
+        hs_stats.frametime = last_frame ? (current_frame - last_frame) / 1000000.0 : 0.0f;
+        hs_stats.allocations = hs_alloc_count;
+        last_frame = current_frame;
+
+        hs_stats_last = hs_stats;
+
+        hs_alloc_count = 0;
+        hs_stats.draw_calls = 0;
+        hs_stats.vertices = 0;
+        hs_stats.buffer_bytes = 0;
+
+#ifdef HS_GL_STATS
+        hs_gl_stats_frame_end();
+#endif
+}
+
 inline static void
 hs_end_frame(const hs_game_data gd)
 {
         glfwSwapBuffers(gd.window);
+        hs_stats_frame_end();
+}
+
+void
+hs_frame_pacer_end_frame(hs_frame_pacer* pacer, const hs_game_data gd)
+{
+        hs_end_frame(gd);
+        if (pacer->measure_latency) {
+                glFinish();
+                pacer->latency_ns = hs_time_ns() - pacer->input_ns;
+        }
 }
 
 inline static void
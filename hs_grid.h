@@ -0,0 +1,620 @@
+#ifndef HS_GRID_H_
+#include "hs_graphics.h"
+
+// Tile grid queries over hs_aroom layers, one bit per tile.
+// Rows are packed in 64 bit words, x is the bit and y the row, like the aroom data.
+// World positions map to tiles through origin (bottom left corner of tile 0, 0) and tile_size.
+
+typedef struct {
+        uint32_t width, height;
+        uint32_t words;     // 64 bit words per row
+        vec2 origin;        // world position of the bottom left corner of tile (0, 0)
+        vec2 tile_size;     // world size of one tile
+        bool outside_solid; // tiles outside the grid count as solid
+        uint32_t version;   // bumped by every change so caches can tell the grid was edited
+        uint64_t* bits;
+} hs_grid;
+
+typedef struct {
+        vec2 origin;
+        vec2 dir;       // does not need to be normalized
+        float max_dist; // world units
+} hs_ray2;
+
+typedef struct {
+        bool hit;
+        vec2i cell;   // the solid cell that was hit
+        vec2i normal; // side of the cell that was entered, zero when the ray starts inside a solid cell
+        float dist;   // world units along the ray
+        vec2 pos;     // world position of the hit
+} hs_grid_hit;
+
+// tiles seen from viewer, solid tiles of the grid block sight
+typedef struct {
+        hs_grid visible;
+        vec2i viewer;
+        uint32_t radius;
+        uint32_t version;   // of the opaque grid the visible tiles were computed for
+        bool valid;
+} hs_fov;
+
+extern hs_grid  hs_grid_create(const uint32_t width, const uint32_t height);
+extern void     hs_grid_free(hs_grid* grid);
+extern hs_grid  hs_grid_from_aroom(const hs_aroom aroom, const uint16_t layer, const uint8_t* solid, const uint32_t solid_count);
+extern void     hs_grid_set_aroom(hs_grid* grid, const hs_aroom aroom, const uint16_t layer, const uint8_t* solid, const uint32_t solid_count);
+extern void     hs_grid_align_tilemap(hs_grid* grid, const hs_tilemap tilemap);
+extern void     hs_grid_align_dyn_tilemap(hs_grid* grid, const hs_dyn_tilemap tilemap);
+
+extern void     hs_grid_set(hs_grid* grid, const uint32_t x, const uint32_t y, const bool solid);
+extern bool     hs_grid_get(const hs_grid grid, const int32_t x, const int32_t y);
+extern vec2i    hs_grid_cell(const hs_grid grid, const vec2 pos);
+extern bool     hs_grid_point_solid(const hs_grid grid, const vec2 pos);
+extern bool     hs_grid_cells_solid(const hs_grid grid, const hs_aabb2i cells);
+extern bool     hs_grid_rect_solid(const hs_grid grid, const hs_rect2 r);
+extern vec2     hs_grid_rect_resolve(const hs_grid grid, hs_rect2* r);
+
+/* Raycasting */
+extern hs_grid_hit hs_grid_raycast(const hs_grid grid, const hs_ray2 ray);
+extern void        hs_grid_raycast_batch(const hs_grid grid, const hs_ray2* rays, hs_grid_hit* hits, const uint32_t count, const uint32_t threads);
+
+/* Field of view */
+extern hs_fov   hs_fov_create(const uint32_t width, const uint32_t height);
+extern void     hs_fov_free(hs_fov* fov);
+extern void     hs_fov_compute(hs_fov* fov, const hs_grid opaque, const vec2i viewer, const uint32_t radius);
+extern bool     hs_fov_update(hs_fov* fov, const hs_grid opaque, const vec2i viewer, const uint32_t radius);
+extern bool     hs_fov_visible(const hs_fov fov, const int32_t x, const int32_t y);
+extern bool     hs_grid_los(const hs_grid opaque, vec2i a, vec2i b);
+extern void     hs_fog_set_fov(hs_fog* fog, const hs_fov fov);
+
+/* Lighting */
+extern uint32_t hs_grid_tex_create(const hs_grid grid);
+extern void     hs_grid_tex_update(const uint32_t tex, const hs_grid grid);
+extern void     hs_lighting_grid_set(hs_lighting* l, const uint32_t tex, const hs_grid grid);
+
+#ifdef HS_IMPL
+#define HS_GRID_IMPL
+#endif //HS_IMPL
+
+#ifdef HS_GRID_IMPL
+
+#define HS_GRID_RESOLVE_ITERATIONS 4
+#define HS_GRID_EDGE_EPSILON 0.0001f
+
+hs_grid
+hs_grid_create(const uint32_t width, const uint32_t height)
+{
+        hs_grid grid = {
+                .width = width,
+                .height = height,
+                .words = (width + 63) / 64,
+                .tile_size = {1.0f, 1.0f},
+        };
+        grid.bits = calloc((size_t)grid.words * height, sizeof(uint64_t));
+        assert(grid.bits);
+        hs_alloc_count++;
+        return grid;
+}
+
+inline void
+hs_grid_free(hs_grid* grid)
+{
+        free(grid->bits);
+        grid->bits = NULL;
+}
+
+// solid lists the tile ids that block, everything else is empty
+hs_grid
+hs_grid_from_aroom(const hs_aroom aroom, const uint16_t layer, const uint8_t* solid, const uint32_t solid_count)
+{
+        hs_grid grid = hs_grid_create(aroom.width, aroom.height);
+        hs_grid_set_aroom(&grid, aroom, layer, solid, solid_count);
+        return grid;
+}
+
+void
+hs_grid_set_aroom(hs_grid* grid, const hs_aroom aroom, const uint16_t layer, const uint8_t* solid, const uint32_t solid_count)
+{
+        assert(grid->width  == aroom.width);
+        assert(grid->height == aroom.height);
+
+        bool is_solid[256] = {0};
+        for (uint32_t i = 0; i < solid_count; i++)
+                is_solid[solid[i]] = true;
+
+        const uint8_t* tiles = hs_aroom_layer(aroom, layer);
+        for (uint32_t y = 0; y < grid->height; y++) {
+                const uint8_t* row = tiles + y * aroom.width;
+                uint64_t* bits = grid->bits + (size_t)y * grid->words;
+
+                for (uint32_t w = 0; w < grid->words; w++) {
+                        const uint32_t end = min(64u, grid->width - w * 64);
+                        uint64_t word = 0;
+                        for (uint32_t b = 0; b < end; b++)
+                                word |= (uint64_t)is_solid[row[w * 64 + b]] << b;
+                        bits[w] = word;
+                }
+        }
+        grid->version++;
+}
+
+// tile (0, 0) of a hs_tilemap is the bottom left one, the map is centered on the origin
+inline void
+hs_grid_align_tilemap(hs_grid* grid, const hs_tilemap tilemap)
+{
+        grid->origin = (vec2){-(float)tilemap.width * tilemap.tile_width, -(float)tilemap.height * tilemap.tile_height};
+        grid->tile_size = (vec2){tilemap.tile_width * 2.0f, tilemap.tile_height * 2.0f};
+}
+
+// hs_dyn_tilemap squares are centered on pos * tile size * 2
+inline void
+hs_grid_align_dyn_tilemap(hs_grid* grid, const hs_dyn_tilemap tilemap)
+{
+        grid->origin = (vec2){-tilemap.tile_width, -tilemap.tile_height};
+        grid->tile_size = (vec2){tilemap.tile_width * 2.0f, tilemap.tile_height * 2.0f};
+}
+
+inline void
+hs_grid_set(hs_grid* grid, const uint32_t x, const uint32_t y, const bool solid)
+{
+        assert(x < grid->width && y < grid->height);
+        uint64_t* word = &grid->bits[(size_t)y * grid->words + x / 64];
+        *word = (*word & ~(1ull << (x % 64))) | ((uint64_t)solid << (x % 64));
+        grid->version++;
+}
+
+inline bool
+hs_grid_get(const hs_grid grid, const int32_t x, const int32_t y)
+{
+        if (x < 0 || y < 0 || x >= (int32_t)grid.width || y >= (int32_t)grid.height)
+                return grid.outside_solid;
+        return (grid.bits[(size_t)y * grid.words + x / 64] >> (x % 64)) & 1;
+}
+
+inline vec2i
+hs_grid_cell(const hs_grid grid, const vec2 pos)
+{
+        return (vec2i){
+                floorf((pos.x - grid.origin.x) / grid.tile_size.x),
+                floorf((pos.y - grid.origin.y) / grid.tile_size.y),
+        };
+}
+
+inline bool
+hs_grid_point_solid(const hs_grid grid, const vec2 pos)
+{
+        const vec2i cell = hs_grid_cell(grid, pos);
+        return hs_grid_get(grid, cell.x, cell.y);
+}
+
+// bits lo to hi of a word
+static inline uint64_t
+hs_grid_mask(const uint32_t lo, const uint32_t hi)
+{
+        const uint64_t upper = hi == 63 ? ~0ull : (1ull << (hi + 1)) - 1;
+        return upper & ~((1ull << lo) - 1);
+}
+
+// inclusive cell range, one masked word test per 64 cells of each row
+bool
+hs_grid_cells_solid(const hs_grid grid, const hs_aabb2i cells)
+{
+        if (grid.outside_solid &&
+            (cells.bl.x < 0 || cells.bl.y < 0 || cells.tr.x >= (int32_t)grid.width || cells.tr.y >= (int32_t)grid.height))
+                return true;
+
+        const int32_t x0 = max(cells.bl.x, 0), x1 = min(cells.tr.x, (int32_t)grid.width - 1);
+        const int32_t y0 = max(cells.bl.y, 0), y1 = min(cells.tr.y, (int32_t)grid.height - 1);
+        if (x0 > x1 || y0 > y1) return false;
+
+        const uint32_t w0 = x0 / 64, w1 = x1 / 64;
+        for (int32_t y = y0; y <= y1; y++) {
+                const uint64_t* row = grid.bits + (size_t)y * grid.words;
+                for (uint32_t w = w0; w <= w1; w++) {
+                        const uint32_t lo = w == w0 ? x0 % 64 : 0;
+                        const uint32_t hi = w == w1 ? x1 % 64 : 63;
+                        if (row[w] & hs_grid_mask(lo, hi)) return true;
+                }
+        }
+        return false;
+}
+
+// cells touched by the rect, edges that only touch a cell (within HS_GRID_EDGE_EPSILON tiles) do not count
+static inline hs_aabb2i
+hs_grid_rect_cells(const hs_grid grid, const hs_rect2 r)
+{
+        return (hs_aabb2i){
+                .bl = {
+                        floorf((r.pos.x - r.half_size.x - grid.origin.x) / grid.tile_size.x + HS_GRID_EDGE_EPSILON),
+                        floorf((r.pos.y - r.half_size.y - grid.origin.y) / grid.tile_size.y + HS_GRID_EDGE_EPSILON),
+                },
+                .tr = {
+                        ceilf((r.pos.x + r.half_size.x - grid.origin.x) / grid.tile_size.x - HS_GRID_EDGE_EPSILON) - 1,
+                        ceilf((r.pos.y + r.half_size.y - grid.origin.y) / grid.tile_size.y - HS_GRID_EDGE_EPSILON) - 1,
+                },
+        };
+}
+
+inline bool
+hs_grid_rect_solid(const hs_grid grid, const hs_rect2 r)
+{
+        return hs_grid_cells_solid(grid, hs_grid_rect_cells(grid, r));
+}
+
+// pushes r out of the solid cells it overlaps and returns how far it moved.
+// the deepest cell is resolved first, by the shortest push that ends next to an empty
+// cell, which keeps rects from snagging on seams and from being pushed into walls
+vec2
+hs_grid_rect_resolve(const hs_grid grid, hs_rect2* r)
+{
+        const vec2 start = r->pos;
+
+        for (uint32_t i = 0; i < HS_GRID_RESOLVE_ITERATIONS; i++) {
+                const hs_aabb2i cells = hs_grid_rect_cells(grid, *r);
+                if (!hs_grid_cells_solid(grid, cells)) break;
+
+                float best_area = 0.0f;
+                vec2i best = {0};
+
+                for (int32_t y = cells.bl.y; y <= cells.tr.y; y++) {
+                        for (int32_t x = cells.bl.x; x <= cells.tr.x; x++) {
+                                if (!hs_grid_get(grid, x, y)) continue;
+
+                                const vec2 bl = {grid.origin.x + x * grid.tile_size.x, grid.origin.y + y * grid.tile_size.y};
+                                const float area =
+                                        (min(r->pos.x + r->half_size.x, bl.x + grid.tile_size.x) - max(r->pos.x - r->half_size.x, bl.x)) *
+                                        (min(r->pos.y + r->half_size.y, bl.y + grid.tile_size.y) - max(r->pos.y - r->half_size.y, bl.y));
+                                if (area > best_area) {
+                                        best_area = area;
+                                        best = (vec2i){x, y};
+                                }
+                        }
+                }
+                if (best_area <= 0.0f) break;
+
+                const vec2 bl = {grid.origin.x + best.x * grid.tile_size.x, grid.origin.y + best.y * grid.tile_size.y};
+                const vec2 tr = vec2_add(bl, grid.tile_size);
+
+                // left, right, down, up
+                const vec2i dirs[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+                const float push[4] = {
+                        r->pos.x + r->half_size.x - bl.x,
+                        tr.x - (r->pos.x - r->half_size.x),
+                        r->pos.y + r->half_size.y - bl.y,
+                        tr.y - (r->pos.y - r->half_size.y),
+                };
+
+                uint32_t dir = 0;
+                float best_push = INFINITY;
+                bool best_open = false;
+                for (uint32_t d = 0; d < 4; d++) {
+                        const bool open = !hs_grid_get(grid, best.x + dirs[d].x, best.y + dirs[d].y);
+                        if ((open && !best_open) || (open == best_open && push[d] < best_push)) {
+                                dir = d;
+                                best_push = push[d];
+                                best_open = open;
+                        }
+                }
+
+                // land exactly on the edge so the next query sees no overlap
+                switch (dir) {
+                case 0: r->pos.x = bl.x - r->half_size.x; break;
+                case 1: r->pos.x = tr.x + r->half_size.x; break;
+                case 2: r->pos.y = bl.y - r->half_size.y; break;
+                case 3: r->pos.y = tr.y + r->half_size.y; break;
+                }
+        }
+
+        return vec2_sub(r->pos, start);
+}
+
+// Amanatides and Woo grid traversal, visits every cell the ray passes through in order
+hs_grid_hit
+hs_grid_raycast(const hs_grid grid, const hs_ray2 ray)
+{
+        hs_grid_hit res = {0};
+
+        vec2i cell = hs_grid_cell(grid, ray.origin);
+        if (hs_grid_get(grid, cell.x, cell.y)) {
+                res = (hs_grid_hit){.hit = true, .cell = cell, .pos = ray.origin};
+                return res;
+        }
+
+        const float len = vec2_len(ray.dir);
+        if (len == 0.0f) return res;
+        const vec2 dir = vec2_scale(ray.dir, 1.0f / len);
+
+        const vec2i step = {dir.x > 0.0f ? 1 : -1, dir.y > 0.0f ? 1 : -1};
+
+        // distance to cross one cell and distance to the first cell border on each axis
+        const vec2 delta = {
+                dir.x != 0.0f ? fabsf(grid.tile_size.x / dir.x) : INFINITY,
+                dir.y != 0.0f ? fabsf(grid.tile_size.y / dir.y) : INFINITY,
+        };
+        const vec2 bl = {grid.origin.x + cell.x * grid.tile_size.x, grid.origin.y + cell.y * grid.tile_size.y};
+        vec2 next = {
+                dir.x != 0.0f ? ((step.x > 0 ? bl.x + grid.tile_size.x : bl.x) - ray.origin.x) / dir.x : INFINITY,
+                dir.y != 0.0f ? ((step.y > 0 ? bl.y + grid.tile_size.y : bl.y) - ray.origin.y) / dir.y : INFINITY,
+        };
+
+        for (;;) {
+                float dist;
+                vec2i normal = {0};
+                if (next.x < next.y) {
+                        dist = next.x;
+                        next.x += delta.x;
+                        cell.x += step.x;
+                        normal.x = -step.x;
+                } else {
+                        dist = next.y;
+                        next.y += delta.y;
+                        cell.y += step.y;
+                        normal.y = -step.y;
+                }
+                if (dist > ray.max_dist) break;
+
+                if (hs_grid_get(grid, cell.x, cell.y)) {
+                        res = (hs_grid_hit){
+                                .hit = true,
+                                .cell = cell,
+                                .normal = normal,
+                                .dist = dist,
+                                .pos = vec2_add(ray.origin, vec2_scale(dir, dist)),
+                        };
+                        break;
+                }
+
+                // outside the grid and moving away from it, nothing left to hit
+                if ((cell.x < 0 && step.x < 0) || (cell.x >= (int32_t)grid.width  && step.x > 0) ||
+                    (cell.y < 0 && step.y < 0) || (cell.y >= (int32_t)grid.height && step.y > 0))
+                        break;
+        }
+
+        return res;
+}
+
+typedef struct {
+        const hs_grid* grid;
+        const hs_ray2* rays;
+        hs_grid_hit* hits;
+} hs_grid_raycast_job;
+
+static void
+hs_grid_raycast_range(void* data, const uint32_t begin, const uint32_t end)
+{
+        const hs_grid_raycast_job* job = data;
+        for (uint32_t i = begin; i < end; i++)
+                job->hits[i] = hs_grid_raycast(*job->grid, job->rays[i]);
+}
+
+// threads = 0 uses every cpu, the grid is only read so rays need no locking
+void
+hs_grid_raycast_batch(const hs_grid grid, const hs_ray2* rays, hs_grid_hit* hits, const uint32_t count, const uint32_t threads)
+{
+        hs_grid_raycast_job job = {.grid = &grid, .rays = rays, .hits = hits};
+        hs_parallel_for(count, threads, hs_grid_raycast_range, &job);
+}
+
+hs_fov
+hs_fov_create(const uint32_t width, const uint32_t height)
+{
+        return (hs_fov){.visible = hs_grid_create(width, height)};
+}
+
+inline void
+hs_fov_free(hs_fov* fov)
+{
+        hs_grid_free(&fov->visible);
+        fov->valid = false;
+}
+
+// clears the words covering the square around center
+static void
+hs_fov_clear(hs_fov* fov, const vec2i center, const uint32_t radius)
+{
+        const int32_t r = radius;
+        const int32_t x0 = max(center.x - r, 0), x1 = min(center.x + r, (int32_t)fov->visible.width - 1);
+        const int32_t y0 = max(center.y - r, 0), y1 = min(center.y + r, (int32_t)fov->visible.height - 1);
+        if (x0 > x1 || y0 > y1) return;
+
+        for (int32_t y = y0; y <= y1; y++)
+                memset(fov->visible.bits + (size_t)y * fov->visible.words + x0 / 64, 0, (x1 / 64 - x0 / 64 + 1) * sizeof(uint64_t));
+}
+
+static inline void
+hs_fov_light(hs_fov* fov, const int32_t x, const int32_t y)
+{
+        if (x < 0 || y < 0 || x >= (int32_t)fov->visible.width || y >= (int32_t)fov->visible.height) return;
+        fov->visible.bits[(size_t)y * fov->visible.words + x / 64] |= 1ull << (x % 64);
+}
+
+// recursive shadowcasting of one octant, rows move away from the viewer and slopes
+// narrow as opaque tiles are found. the transform maps octant space to the grid
+static void
+hs_fov_cast(hs_fov* fov, const hs_grid opaque, const uint32_t row, float start, const float end,
+            const int32_t xx, const int32_t xy, const int32_t yx, const int32_t yy)
+{
+        if (start < end) return;
+
+        const int32_t radius = fov->radius;
+        const int32_t radius2 = radius * radius;
+        float new_start = 0.0f;
+
+        for (int32_t j = row; j <= radius; j++) {
+                const int32_t dy = -j;
+                bool blocked = false;
+
+                for (int32_t dx = -j; dx <= 0; dx++) {
+                        const int32_t x = fov->viewer.x + dx * xx + dy * xy;
+                        const int32_t y = fov->viewer.y + dx * yx + dy * yy;
+                        const float l_slope = (dx - 0.5f) / (dy + 0.5f);
+                        const float r_slope = (dx + 0.5f) / (dy - 0.5f);
+
+                        if (start < r_slope) continue;
+                        if (end > l_slope) break;
+
+                        if (dx * dx + dy * dy <= radius2) hs_fov_light(fov, x, y);
+
+                        const bool solid = hs_grid_get(opaque, x, y);
+                        if (blocked) {
+                                if (solid) {
+                                        new_start = r_slope;
+                                } else {
+                                        blocked = false;
+                                        start = new_start;
+                                }
+                        } else if (solid && j < radius) {
+                                blocked = true;
+                                hs_fov_cast(fov, opaque, j + 1, start, l_slope, xx, xy, yx, yy);
+                                new_start = r_slope;
+                        }
+                }
+                if (blocked) break;
+        }
+}
+
+void
+hs_fov_compute(hs_fov* fov, const hs_grid opaque, const vec2i viewer, const uint32_t radius)
+{
+        assert(fov->visible.width == opaque.width && fov->visible.height == opaque.height);
+
+        // only the square the last field could have lit needs clearing
+        if (fov->valid) hs_fov_clear(fov, fov->viewer, fov->radius);
+        else            memset(fov->visible.bits, 0, (size_t)fov->visible.words * fov->visible.height * sizeof(uint64_t));
+
+        fov->viewer = viewer;
+        fov->radius = radius;
+        fov->version = opaque.version;
+        fov->valid = true;
+
+        static const int32_t octants[8][4] = {
+                { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+                {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1},
+        };
+
+        hs_fov_light(fov, viewer.x, viewer.y);
+        for (uint32_t o = 0; o < 8; o++)
+                hs_fov_cast(fov, opaque, 1, 1.0f, 0.0f, octants[o][0], octants[o][1], octants[o][2], octants[o][3]);
+}
+
+// recomputes only when the viewer changed tile, the radius changed or the grid was edited.
+// returns true when the visible tiles changed
+bool
+hs_fov_update(hs_fov* fov, const hs_grid opaque, const vec2i viewer, const uint32_t radius)
+{
+        if (fov->valid && fov->viewer.x == viewer.x && fov->viewer.y == viewer.y &&
+            fov->radius == radius && fov->version == opaque.version)
+                return false;
+
+        hs_fov_compute(fov, opaque, viewer, radius);
+        return true;
+}
+
+// one bit test, enough for every enemy asking if the viewer sees it
+inline bool
+hs_fov_visible(const hs_fov fov, const int32_t x, const int32_t y)
+{
+        return hs_grid_get(fov.visible, x, y);
+}
+
+// bresenham line between tile centers, true when no solid tile lies strictly between a and b.
+// always walks from the lower endpoint so los(a, b) == los(b, a)
+bool
+hs_grid_los(const hs_grid opaque, vec2i a, vec2i b)
+{
+        if (b.x < a.x || (b.x == a.x && b.y < a.y)) {
+                const vec2i tmp = a;
+                a = b;
+                b = tmp;
+        }
+
+        if (a.x == b.x && a.y == b.y) return true;
+
+        const int32_t dx = abs(b.x - a.x), dy = -abs(b.y - a.y);
+        const int32_t sx = a.x < b.x ? 1 : -1, sy = a.y < b.y ? 1 : -1;
+        int32_t err = dx + dy;
+
+        for (;;) {
+                const int32_t e2 = err * 2;
+                if (e2 >= dy) {
+                        err += dy;
+                        a.x += sx;
+                }
+                if (e2 <= dx) {
+                        err += dx;
+                        a.y += sy;
+                }
+                if (a.x == b.x && a.y == b.y) return true;
+                if (hs_grid_get(opaque, a.x, a.y)) return false;
+        }
+}
+
+// visible tiles of the field become HS_FOG_VISIBLE and the ones that were visible before
+// drop to HS_FOG_EXPLORED. only the squares around the old and new viewer are touched
+void
+hs_fog_set_fov(hs_fog* fog, const hs_fov fov)
+{
+        assert(fog->width == fov.visible.width && fog->height == fov.visible.height);
+
+        for (int32_t y = fog->lit.bl.y; y <= fog->lit.tr.y; y++)
+                for (int32_t x = fog->lit.bl.x; x <= fog->lit.tr.x; x++)
+                        if (hs_fog_get(*fog, x, y) == HS_FOG_VISIBLE && !hs_fov_visible(fov, x, y))
+                                hs_fog_set(fog, x, y, HS_FOG_EXPLORED);
+
+        const int32_t r = fov.radius;
+        fog->lit = (hs_aabb2i){
+                .bl = {max(fov.viewer.x - r, 0), max(fov.viewer.y - r, 0)},
+                .tr = {min(fov.viewer.x + r, (int32_t)fog->width - 1), min(fov.viewer.y + r, (int32_t)fog->height - 1)},
+        };
+        for (int32_t y = fog->lit.bl.y; y <= fog->lit.tr.y; y++)
+                for (int32_t x = fog->lit.bl.x; x <= fog->lit.tr.x; x++)
+                        if (hs_fov_visible(fov, x, y))
+                                hs_fog_set(fog, x, y, HS_FOG_VISIBLE);
+}
+
+// one R8 texel per cell, 255 when solid
+uint32_t
+hs_grid_tex_create(const hs_grid grid)
+{
+        uint32_t tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, grid.width, grid.height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        hs_stats_texture_set(tex, (uint64_t)grid.width * grid.height);
+
+        hs_grid_tex_update(tex, grid);
+        return tex;
+}
+
+// uploads the whole grid, call it when grid.version changed
+void
+hs_grid_tex_update(const uint32_t tex, const hs_grid grid)
+{
+        uint8_t* texels = malloc((size_t)grid.width * grid.height);
+        assert(texels);
+
+        for (uint32_t y = 0; y < grid.height; y++)
+                for (uint32_t x = 0; x < grid.width; x++)
+                        texels[x + (size_t)y * grid.width] = hs_grid_get(grid, x, y) ? 255 : 0;
+
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, grid.width, grid.height, GL_RED, GL_UNSIGNED_BYTE, texels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        free(texels);
+}
+
+// solid cells of grid block the lights, tex comes from hs_grid_tex_create
+inline void
+hs_lighting_grid_set(hs_lighting* l, const uint32_t tex, const hs_grid grid)
+{
+        hs_lighting_occluders_set(l, tex, grid.origin, grid.tile_size, grid.width, grid.height);
+}
+
+#endif // HS_GRID_IMPL
+
+#define HS_GRID_H_
+#endif // HS_GRID_H_
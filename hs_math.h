@@ -146,6 +146,15 @@ vec2_scale(const vec2 vector, const float scalar)
         };
 }
 
+inline static vec2
+vec2_lerp(const vec2 v1, const vec2 v2, const float t)
+{
+        return (vec2){
+                v1.x + (v2.x - v1.x) * t,
+                v1.y + (v2.y - v1.y) * t,
+        };
+}
+
 inline static vec2i
 vec2i_scale(const vec2i vector, const int32_t scalar)
 {
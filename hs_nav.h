@@ -0,0 +1,705 @@
+#ifndef HS_NAV_H_
+#include "hs_grid.h"
+
+// Navigation over the empty cells of a hs_grid.
+// A flow field stores the step count to the closest target for every cell and the
+// direction to walk from it, so any number of entities can follow it with one lookup.
+
+#define HS_FLOW_UNREACHABLE INT32_MAX
+#define HS_FLOW_NONE 8 // direction of targets and unreachable cells
+#define HS_FLOW_DIRTY 0x80
+
+typedef struct {
+        uint32_t width, height;
+        int32_t base;          // real cost is cost + base, lets hs_flow_field_retarget shift every cell at once
+        vec2i target;          // set when built from a single target
+        uint32_t target_count;
+        int32_t* cost;
+        uint32_t* queue;
+        uint8_t* dir;          // index into hs_flow_dirs
+} hs_flow_field;
+
+#define HS_NAV_NO_ROOM UINT16_MAX
+#define HS_NAV_CACHE_SIZE 256
+#define HS_NAV_CACHE_MAX_NODES 65536
+
+// a portal cell on the border of a room, paired with the cell across the border
+typedef struct {
+        vec2i cell;
+        uint16_t room;
+        uint32_t edge_start, edge_count; // into hs_nav.edges
+} hs_nav_node;
+
+typedef struct {
+        uint32_t to;
+        uint32_t cost;
+} hs_nav_edge;
+
+typedef struct {
+        uint32_t key;                    // start room << 16 | goal room, UINT32_MAX when empty
+        uint32_t start, count;           // into hs_nav.cache_nodes
+} hs_nav_cache_entry;
+
+// HPA* over rooms, usually the ones from hs_bsp_recti_split_in_place_append.
+// rooms are inclusive cell rects, a cell belongs to the last room that covers it
+typedef struct {
+        uint32_t width, height;
+        uint32_t room_count;
+        uint16_t* room_of;               // per cell
+        uint32_t* room_first;            // room_count + 1 offsets into room_nodes
+        uint32_t* room_nodes;
+        hs_dynarr nodes;                 // hs_nav_node
+        hs_dynarr edges;                 // hs_nav_edge
+
+        // search scratch
+        uint32_t search;
+        uint32_t* cell_stamp;
+        uint32_t* cell_dist;
+        uint32_t* queue;
+        uint32_t* node_stamp;            // per node and the virtual goal node
+        uint32_t* node_g;
+        uint32_t* node_parent;
+        uint32_t* node_goal;             // distance from a node in the goal room to the goal
+        uint8_t* node_closed;
+        hs_dynarr open;                  // hs_nav_open heap
+        hs_dynarr chain;                 // uint32_t node indices of the last route
+
+        hs_nav_cache_entry cache[HS_NAV_CACHE_SIZE];
+        hs_dynarr cache_nodes;           // uint32_t
+} hs_nav;
+
+/* Flow field */
+extern hs_flow_field hs_flow_field_create(const uint32_t width, const uint32_t height);
+extern void          hs_flow_field_free(hs_flow_field* ff);
+extern void          hs_flow_field_build(hs_flow_field* ff, const hs_grid grid, const vec2i* targets, const uint32_t target_count);
+extern void          hs_flow_field_retarget(hs_flow_field* ff, const hs_grid grid, const vec2i target);
+extern uint32_t      hs_flow_field_cost(const hs_flow_field ff, const int32_t x, const int32_t y);
+extern vec2          hs_flow_field_dir(const hs_flow_field ff, const int32_t x, const int32_t y);
+extern vec2          hs_flow_field_sample(const hs_flow_field ff, const hs_grid grid, const vec2 pos);
+
+/* Room graph */
+extern hs_nav   hs_nav_create(const hs_grid grid, const hs_aabb2i* rooms, const uint32_t room_count);
+extern void     hs_nav_free(hs_nav* nav);
+extern void     hs_nav_cache_clear(hs_nav* nav);
+extern uint32_t hs_nav_path(hs_nav* nav, const hs_grid grid, const vec2i start, const vec2i goal, hs_dynarr* path);
+
+#ifdef HS_IMPL
+#define HS_NAV_IMPL
+#endif //HS_IMPL
+
+#ifdef HS_NAV_IMPL
+
+// orthogonal first so ties prefer straight moves
+static const vec2i hs_flow_steps[8] = {
+        { 1,  0}, {-1,  0}, { 0,  1}, { 0, -1},
+        { 1,  1}, {-1,  1}, { 1, -1}, {-1, -1},
+};
+
+static const vec2 hs_flow_dirs[HS_FLOW_NONE + 1] = {
+        { 1.0f,  0.0f}, {-1.0f,  0.0f}, { 0.0f,  1.0f}, { 0.0f, -1.0f},
+        { 0.70710678f,  0.70710678f}, {-0.70710678f,  0.70710678f},
+        { 0.70710678f, -0.70710678f}, {-0.70710678f, -0.70710678f},
+        { 0.0f,  0.0f},
+};
+
+hs_flow_field
+hs_flow_field_create(const uint32_t width, const uint32_t height)
+{
+        const size_t cells = (size_t)width * height;
+        hs_flow_field ff = {.width = width, .height = height};
+
+        // one block for cost, queue and dir
+        uint8_t* mem = malloc(cells * (sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint8_t)));
+        assert(mem);
+        hs_alloc_count++;
+
+        ff.cost  = (int32_t*)mem;
+        ff.queue = (uint32_t*)(mem + cells * sizeof(int32_t));
+        ff.dir   = mem + cells * (sizeof(int32_t) + sizeof(uint32_t));
+        for (size_t i = 0; i < cells; i++) ff.cost[i] = HS_FLOW_UNREACHABLE;
+        memset(ff.dir, HS_FLOW_NONE, cells);
+        return ff;
+}
+
+inline void
+hs_flow_field_free(hs_flow_field* ff)
+{
+        free(ff->cost);
+        ff->cost = NULL;
+        ff->queue = NULL;
+        ff->dir = NULL;
+}
+
+// breadth first from every cell already in the queue, only lowers costs.
+// returns how many cells were queued in total
+static uint32_t
+hs_flow_field_propagate(hs_flow_field* ff, const hs_grid grid, uint32_t queued)
+{
+        for (uint32_t head = 0; head < queued; head++) {
+                const uint32_t i = ff->queue[head];
+                const int32_t x = i % ff->width, y = i / ff->width;
+                const int32_t next = ff->cost[i] + 1;
+
+                for (uint32_t s = 0; s < 4; s++) {
+                        const int32_t nx = x + hs_flow_steps[s].x, ny = y + hs_flow_steps[s].y;
+                        if (nx < 0 || ny < 0 || nx >= (int32_t)ff->width || ny >= (int32_t)ff->height) continue;
+
+                        const uint32_t n = nx + ny * ff->width;
+                        if (next >= ff->cost[n] || hs_grid_get(grid, nx, ny)) continue;
+                        ff->cost[n] = next;
+                        ff->queue[queued++] = n;
+                }
+        }
+        return queued;
+}
+
+// steepest descent over the 8 neighbors, diagonals only when both orthogonal cells are open
+static void
+hs_flow_field_set_dir(hs_flow_field* ff, const hs_grid grid, const int32_t x, const int32_t y)
+{
+        const uint32_t i = x + y * ff->width;
+        int32_t best = ff->cost[i];
+        uint8_t dir = HS_FLOW_NONE;
+
+        if (best != HS_FLOW_UNREACHABLE) {
+                for (uint32_t s = 0; s < 8; s++) {
+                        const int32_t nx = x + hs_flow_steps[s].x, ny = y + hs_flow_steps[s].y;
+                        if (nx < 0 || ny < 0 || nx >= (int32_t)ff->width || ny >= (int32_t)ff->height) continue;
+                        if (s >= 4 && (hs_grid_get(grid, nx, y) || hs_grid_get(grid, x, ny))) continue;
+
+                        const int32_t cost = ff->cost[nx + ny * ff->width];
+                        if (cost < best) {
+                                best = cost;
+                                dir = s;
+                        }
+                }
+        }
+        ff->dir[i] = dir;
+}
+
+void
+hs_flow_field_build(hs_flow_field* ff, const hs_grid grid, const vec2i* targets, const uint32_t target_count)
+{
+        assert(ff->width == grid.width && ff->height == grid.height);
+
+        const size_t cells = (size_t)ff->width * ff->height;
+        for (size_t i = 0; i < cells; i++) ff->cost[i] = HS_FLOW_UNREACHABLE;
+        ff->base = 0;
+        ff->target_count = target_count;
+        if (target_count) ff->target = targets[0];
+
+        uint32_t queued = 0;
+        for (uint32_t t = 0; t < target_count; t++) {
+                const vec2i c = targets[t];
+                if (c.x < 0 || c.y < 0 || c.x >= (int32_t)ff->width || c.y >= (int32_t)ff->height) continue;
+
+                const uint32_t i = c.x + c.y * ff->width;
+                if (ff->cost[i] == 0 || hs_grid_get(grid, c.x, c.y)) continue;
+                ff->cost[i] = 0;
+                ff->queue[queued++] = i;
+        }
+        hs_flow_field_propagate(ff, grid, queued);
+
+        for (uint32_t y = 0; y < ff->height; y++)
+                for (uint32_t x = 0; x < ff->width; x++)
+                        hs_flow_field_set_dir(ff, grid, x, y);
+}
+
+// moves the target of a single target field without rebuilding it.
+// if the target moved k steps, every path to the old target extends to the new one
+// with k more steps, so the new field is min(old + k, distance from the new target).
+// adding k is a change of base, and only the cells that got closer are visited
+void
+hs_flow_field_retarget(hs_flow_field* ff, const hs_grid grid, const vec2i target)
+{
+        if (ff->target_count != 1 ||
+            target.x < 0 || target.y < 0 || target.x >= (int32_t)ff->width || target.y >= (int32_t)ff->height ||
+            ff->cost[target.x + target.y * ff->width] == HS_FLOW_UNREACHABLE) {
+                hs_flow_field_build(ff, grid, &target, 1);
+                return;
+        }
+
+        const uint32_t t = target.x + target.y * ff->width;
+        const int32_t k = ff->cost[t] + ff->base;
+        ff->target = target;
+        if (k == 0) return;
+
+        // keep room below the stored costs, rebuild long before they could wrap
+        if (ff->base > INT32_MAX / 2) {
+                hs_flow_field_build(ff, grid, &target, 1);
+                return;
+        }
+
+        ff->base += k;
+        ff->cost[t] = -ff->base;
+        ff->queue[0] = t;
+        const uint32_t queued = hs_flow_field_propagate(ff, grid, 1);
+
+        // only cells next to a changed cost can change direction, mark them first
+        // so each one is recomputed once
+        for (uint32_t pass = 0; pass < 2; pass++) {
+                for (uint32_t q = 0; q < queued; q++) {
+                        const int32_t x = ff->queue[q] % ff->width, y = ff->queue[q] / ff->width;
+                        for (int32_t ny = max(y - 1, 0); ny <= min(y + 1, (int32_t)ff->height - 1); ny++) {
+                                for (int32_t nx = max(x - 1, 0); nx <= min(x + 1, (int32_t)ff->width - 1); nx++) {
+                                        uint8_t* dir = &ff->dir[nx + ny * ff->width];
+                                        if (!pass)                         *dir |= HS_FLOW_DIRTY;
+                                        else if (*dir & HS_FLOW_DIRTY)     hs_flow_field_set_dir(ff, grid, nx, ny);
+                                }
+                        }
+                }
+        }
+}
+
+// steps to the closest target, HS_FLOW_UNREACHABLE for walls and cut off cells
+inline uint32_t
+hs_flow_field_cost(const hs_flow_field ff, const int32_t x, const int32_t y)
+{
+        if (x < 0 || y < 0 || x >= (int32_t)ff.width || y >= (int32_t)ff.height) return HS_FLOW_UNREACHABLE;
+        const int32_t cost = ff.cost[x + y * ff.width];
+        return cost == HS_FLOW_UNREACHABLE ? HS_FLOW_UNREACHABLE : (uint32_t)(cost + ff.base);
+}
+
+// unit direction to walk from a cell, zero on targets and unreachable cells
+inline vec2
+hs_flow_field_dir(const hs_flow_field ff, const int32_t x, const int32_t y)
+{
+        if (x < 0 || y < 0 || x >= (int32_t)ff.width || y >= (int32_t)ff.height) return hs_flow_dirs[HS_FLOW_NONE];
+        return hs_flow_dirs[ff.dir[x + y * ff.width]];
+}
+
+inline vec2
+hs_flow_field_sample(const hs_flow_field ff, const hs_grid grid, const vec2 pos)
+{
+        const vec2i cell = hs_grid_cell(grid, pos);
+        return hs_flow_field_dir(ff, cell.x, cell.y);
+}
+
+typedef struct {
+        uint32_t f;
+        uint32_t node;
+} hs_nav_open;
+
+static void
+hs_nav_open_push(hs_dynarr* open, const uint32_t f, const uint32_t node)
+{
+        hs_dynarr_push((*open), hs_nav_open, ((hs_nav_open){f, node}));
+        hs_nav_open* heap = hs_dynarr_data((*open), hs_nav_open);
+        for (size_t i = open->len - 1; i > 0 && heap[(i - 1) / 2].f > heap[i].f; i = (i - 1) / 2) {
+                const hs_nav_open tmp = heap[i];
+                heap[i] = heap[(i - 1) / 2];
+                heap[(i - 1) / 2] = tmp;
+        }
+}
+
+static hs_nav_open
+hs_nav_open_pop(hs_dynarr* open)
+{
+        hs_nav_open* heap = hs_dynarr_data((*open), hs_nav_open);
+        const hs_nav_open top = heap[0];
+        heap[0] = heap[--open->len];
+
+        for (size_t i = 0;;) {
+                const size_t l = i * 2 + 1, r = l + 1;
+                size_t smallest = i;
+                if (l < open->len && heap[l].f < heap[smallest].f) smallest = l;
+                if (r < open->len && heap[r].f < heap[smallest].f) smallest = r;
+                if (smallest == i) break;
+
+                const hs_nav_open tmp = heap[i];
+                heap[i] = heap[smallest];
+                heap[smallest] = tmp;
+                i = smallest;
+        }
+        return top;
+}
+
+static inline bool
+hs_nav_walkable(const hs_nav* nav, const hs_grid grid, const int32_t x, const int32_t y, const uint16_t room)
+{
+        if (x < 0 || y < 0 || x >= (int32_t)nav->width || y >= (int32_t)nav->height) return false;
+        return nav->room_of[x + y * nav->width] == room && !hs_grid_get(grid, x, y);
+}
+
+// breadth first search that never leaves room, fills cell_dist for the current stamp
+static void
+hs_nav_room_bfs(hs_nav* nav, const hs_grid grid, const uint16_t room, const vec2i from)
+{
+        static const vec2i steps[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+        nav->search++;
+        if (!hs_nav_walkable(nav, grid, from.x, from.y, room)) return;
+
+        const uint32_t first = from.x + from.y * nav->width;
+        nav->cell_stamp[first] = nav->search;
+        nav->cell_dist[first] = 0;
+        nav->queue[0] = first;
+
+        uint32_t queued = 1;
+        for (uint32_t head = 0; head < queued; head++) {
+                const uint32_t i = nav->queue[head];
+                const int32_t x = i % nav->width, y = i / nav->width;
+
+                for (uint32_t s = 0; s < 4; s++) {
+                        const int32_t nx = x + steps[s].x, ny = y + steps[s].y;
+                        if (!hs_nav_walkable(nav, grid, nx, ny, room)) continue;
+
+                        const uint32_t n = nx + ny * nav->width;
+                        if (nav->cell_stamp[n] == nav->search) continue;
+                        nav->cell_stamp[n] = nav->search;
+                        nav->cell_dist[n] = nav->cell_dist[i] + 1;
+                        nav->queue[queued++] = n;
+                }
+        }
+}
+
+static inline uint32_t
+hs_nav_bfs_dist(const hs_nav* nav, const vec2i cell)
+{
+        const uint32_t i = cell.x + cell.y * nav->width;
+        return nav->cell_stamp[i] == nav->search ? nav->cell_dist[i] : UINT32_MAX;
+}
+
+static inline hs_nav_node*
+hs_nav_node_get(const hs_nav* nav, const uint32_t node)
+{
+        return &hs_dynarr_idx(nav->nodes, hs_nav_node, node);
+}
+
+// pushes the cells from from to to, both included, walking inside room
+static bool
+hs_nav_walk(hs_nav* nav, const hs_grid grid, const uint16_t room, const vec2i from, const vec2i to, hs_dynarr* path)
+{
+        static const vec2i steps[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+        hs_nav_room_bfs(nav, grid, room, to);
+        uint32_t dist = hs_nav_bfs_dist(nav, from);
+        if (dist == UINT32_MAX) return false;
+
+        vec2i cell = from;
+        hs_dynarr_push((*path), vec2i, cell);
+        while (dist) {
+                for (uint32_t s = 0; s < 4; s++) {
+                        const vec2i next = {cell.x + steps[s].x, cell.y + steps[s].y};
+                        if (!hs_nav_walkable(nav, grid, next.x, next.y, room) || hs_nav_bfs_dist(nav, next) != dist - 1)
+                                continue;
+                        cell = next;
+                        break;
+                }
+                dist--;
+                hs_dynarr_push((*path), vec2i, cell);
+        }
+        return true;
+}
+
+// portals are the middle of every run of open cell pairs between the same two rooms
+static void
+hs_nav_add_portals(hs_nav* nav, const hs_grid grid, const vec2i along, const vec2i across)
+{
+        const uint32_t lines = along.x ? nav->height : nav->width;
+        const uint32_t length = along.x ? nav->width : nav->height;
+
+        for (uint32_t line = 0; line + 1 < lines; line++) {
+                uint32_t run_start = 0, run_length = 0;
+                uint16_t run_a = HS_NAV_NO_ROOM, run_b = HS_NAV_NO_ROOM;
+
+                for (uint32_t i = 0; i <= length; i++) {
+                        const vec2i a = {along.x * i + across.x * line, along.y * i + across.y * line};
+                        const vec2i b = {a.x + across.x, a.y + across.y};
+
+                        uint16_t ra = HS_NAV_NO_ROOM, rb = HS_NAV_NO_ROOM;
+                        if (i < length && !hs_grid_get(grid, a.x, a.y) && !hs_grid_get(grid, b.x, b.y)) {
+                                ra = nav->room_of[a.x + a.y * nav->width];
+                                rb = nav->room_of[b.x + b.y * nav->width];
+                                if (ra == rb || ra == HS_NAV_NO_ROOM || rb == HS_NAV_NO_ROOM)
+                                        ra = rb = HS_NAV_NO_ROOM;
+                        }
+
+                        if (run_length && (ra != run_a || rb != run_b)) {
+                                const uint32_t mid = run_start + run_length / 2;
+                                const vec2i pa = {along.x * mid + across.x * line, along.y * mid + across.y * line};
+                                const vec2i pb = {pa.x + across.x, pa.y + across.y};
+                                hs_dynarr_push(nav->nodes, hs_nav_node, ((hs_nav_node){.cell = pa, .room = run_a}));
+                                hs_dynarr_push(nav->nodes, hs_nav_node, ((hs_nav_node){.cell = pb, .room = run_b}));
+                                run_length = 0;
+                        }
+                        if (ra == HS_NAV_NO_ROOM) continue;
+                        if (!run_length) {
+                                run_start = i;
+                                run_a = ra;
+                                run_b = rb;
+                        }
+                        run_length++;
+                }
+        }
+}
+
+hs_nav
+hs_nav_create(const hs_grid grid, const hs_aabb2i* rooms, const uint32_t room_count)
+{
+        assert(room_count < HS_NAV_NO_ROOM);
+
+        hs_nav nav = {
+                .width = grid.width,
+                .height = grid.height,
+                .room_count = room_count,
+                .nodes = hs_dynarr_init(hs_nav_node, 64),
+                .edges = hs_dynarr_init(hs_nav_edge, 256),
+                .open = hs_dynarr_init(hs_nav_open, 64),
+                .chain = hs_dynarr_init(uint32_t, 64),
+                .cache_nodes = hs_dynarr_init(uint32_t, 256),
+        };
+
+        const size_t cells = (size_t)grid.width * grid.height;
+        nav.room_of = malloc(cells * sizeof(uint16_t));
+        nav.cell_stamp = calloc(cells, sizeof(uint32_t));
+        nav.cell_dist = malloc(cells * sizeof(uint32_t));
+        nav.queue = malloc(cells * sizeof(uint32_t));
+        assert(nav.room_of && nav.cell_stamp && nav.cell_dist && nav.queue);
+        hs_alloc_count += 4;
+
+        for (size_t i = 0; i < cells; i++) nav.room_of[i] = HS_NAV_NO_ROOM;
+        for (uint32_t r = 0; r < room_count; r++)
+                for (int32_t y = max(rooms[r].bl.y, 0); y <= min(rooms[r].tr.y, (int32_t)grid.height - 1); y++)
+                        for (int32_t x = max(rooms[r].bl.x, 0); x <= min(rooms[r].tr.x, (int32_t)grid.width - 1); x++)
+                                nav.room_of[x + y * grid.width] = r;
+
+        // nodes come in pairs, node ^ 1 is the cell across the border
+        hs_nav_add_portals(&nav, grid, (vec2i){0, 1}, (vec2i){1, 0});
+        hs_nav_add_portals(&nav, grid, (vec2i){1, 0}, (vec2i){0, 1});
+        const uint32_t node_count = nav.nodes.len;
+
+        nav.room_first = calloc(room_count + 1, sizeof(uint32_t));
+        nav.room_nodes = malloc((node_count + 1) * sizeof(uint32_t));
+        nav.node_stamp = calloc(node_count + 1, sizeof(uint32_t));
+        nav.node_g = malloc((node_count + 1) * sizeof(uint32_t));
+        nav.node_parent = malloc((node_count + 1) * sizeof(uint32_t));
+        nav.node_goal = malloc((node_count + 1) * sizeof(uint32_t));
+        nav.node_closed = malloc(node_count + 1);
+        assert(nav.room_first && nav.room_nodes && nav.node_stamp && nav.node_g &&
+               nav.node_parent && nav.node_goal && nav.node_closed);
+        hs_alloc_count += 7;
+
+        for (uint32_t n = 0; n < node_count; n++)
+                nav.room_first[hs_nav_node_get(&nav, n)->room + 1]++;
+        for (uint32_t r = 0; r < room_count; r++)
+                nav.room_first[r + 1] += nav.room_first[r];
+        // counting sort, room_first[r] ends up at the start of room r + 1 and is shifted back after
+        for (uint32_t n = 0; n < node_count; n++)
+                nav.room_nodes[nav.room_first[hs_nav_node_get(&nav, n)->room]++] = n;
+        for (uint32_t r = room_count; r > 0; r--)
+                nav.room_first[r] = nav.room_first[r - 1];
+        nav.room_first[0] = 0;
+
+        // one edge across the portal, then the distance to every node reachable inside the room
+        for (uint32_t n = 0; n < node_count; n++) {
+                hs_nav_node* node = hs_nav_node_get(&nav, n);
+                node->edge_start = nav.edges.len;
+                hs_dynarr_push(nav.edges, hs_nav_edge, ((hs_nav_edge){n ^ 1, 1}));
+
+                hs_nav_room_bfs(&nav, grid, node->room, node->cell);
+                for (uint32_t i = nav.room_first[node->room]; i < nav.room_first[node->room + 1]; i++) {
+                        const uint32_t other = nav.room_nodes[i];
+                        const uint32_t dist = hs_nav_bfs_dist(&nav, hs_nav_node_get(&nav, other)->cell);
+                        if (other == n || dist == UINT32_MAX) continue;
+                        hs_dynarr_push(nav.edges, hs_nav_edge, ((hs_nav_edge){other, dist}));
+                }
+                node->edge_count = nav.edges.len - node->edge_start;
+        }
+
+        hs_nav_cache_clear(&nav);
+        return nav;
+}
+
+void
+hs_nav_free(hs_nav* nav)
+{
+        free(nav->room_of);
+        free(nav->room_first);
+        free(nav->room_nodes);
+        free(nav->cell_stamp);
+        free(nav->cell_dist);
+        free(nav->queue);
+        free(nav->node_stamp);
+        free(nav->node_g);
+        free(nav->node_parent);
+        free(nav->node_goal);
+        free(nav->node_closed);
+        hs_dynarr_free(nav->nodes);
+        hs_dynarr_free(nav->edges);
+        hs_dynarr_free(nav->open);
+        hs_dynarr_free(nav->chain);
+        hs_dynarr_free(nav->cache_nodes);
+        *nav = (hs_nav){0};
+}
+
+// call after the grid or the rooms change
+inline void
+hs_nav_cache_clear(hs_nav* nav)
+{
+        for (uint32_t i = 0; i < HS_NAV_CACHE_SIZE; i++) nav->cache[i].key = UINT32_MAX;
+        hs_dynarr_clear(nav->cache_nodes);
+}
+
+static inline uint32_t
+hs_nav_heuristic(const hs_nav* nav, const uint32_t node, const vec2i goal)
+{
+        const vec2i cell = hs_nav_node_get(nav, node)->cell;
+        return abs(cell.x - goal.x) + abs(cell.y - goal.y);
+}
+
+// A* over the portal nodes, start and goal are linked to the nodes of their rooms
+// with room searches. fills nav->chain, false when the goal cannot be reached
+static bool
+hs_nav_search(hs_nav* nav, const hs_grid grid, const vec2i start, const vec2i goal, const uint16_t rs, const uint16_t rg)
+{
+        const uint32_t goal_node = nav->nodes.len;
+        hs_dynarr_clear(nav->chain);
+        hs_dynarr_clear(nav->open);
+
+        // every goal room node gets its distance to the goal, other rooms never read it
+        hs_nav_room_bfs(nav, grid, rg, goal);
+        for (uint32_t i = nav->room_first[rg]; i < nav->room_first[rg + 1]; i++) {
+                const uint32_t n = nav->room_nodes[i];
+                nav->node_goal[n] = hs_nav_bfs_dist(nav, hs_nav_node_get(nav, n)->cell);
+        }
+
+        // node_stamp marks the node values written by this search
+        hs_nav_room_bfs(nav, grid, rs, start);
+        const uint32_t stamp = nav->search;
+        for (uint32_t i = nav->room_first[rs]; i < nav->room_first[rs + 1]; i++) {
+                const uint32_t n = nav->room_nodes[i];
+                const uint32_t dist = hs_nav_bfs_dist(nav, hs_nav_node_get(nav, n)->cell);
+                if (dist == UINT32_MAX) continue;
+
+                nav->node_stamp[n] = stamp;
+                nav->node_g[n] = dist;
+                nav->node_parent[n] = UINT32_MAX;
+                nav->node_closed[n] = false;
+                hs_nav_open_push(&nav->open, dist + hs_nav_heuristic(nav, n, goal), n);
+        }
+
+        while (nav->open.len) {
+                const hs_nav_open top = hs_nav_open_pop(&nav->open);
+                const uint32_t n = top.node;
+                if (nav->node_closed[n]) continue;
+                nav->node_closed[n] = true;
+
+                if (n == goal_node) {
+                        for (uint32_t c = nav->node_parent[n]; c != UINT32_MAX; c = nav->node_parent[c]) {
+                                hs_dynarr_push(nav->chain, uint32_t, c);
+                        }
+                        // reverse into start to goal order
+                        uint32_t* chain = hs_dynarr_data(nav->chain, uint32_t);
+                        for (size_t i = 0, j = nav->chain.len - 1; i < j; i++, j--) {
+                                const uint32_t tmp = chain[i];
+                                chain[i] = chain[j];
+                                chain[j] = tmp;
+                        }
+                        return true;
+                }
+
+                const hs_nav_node* node = hs_nav_node_get(nav, n);
+                const uint32_t g = nav->node_g[n];
+
+                // relax the virtual goal node from nodes in the goal room
+                uint32_t edge_count = node->edge_count;
+                hs_nav_edge goal_edge = {goal_node, UINT32_MAX};
+                if (node->room == rg && nav->node_goal[n] != UINT32_MAX) {
+                        goal_edge.cost = nav->node_goal[n];
+                        edge_count++;
+                }
+
+                for (uint32_t e = 0; e < edge_count; e++) {
+                        const hs_nav_edge edge = e < node->edge_count ?
+                                hs_dynarr_idx(nav->edges, hs_nav_edge, node->edge_start + e) : goal_edge;
+                        const uint32_t to = edge.to;
+                        const uint32_t new_g = g + edge.cost;
+
+                        if (nav->node_stamp[to] != stamp) {
+                                nav->node_stamp[to] = stamp;
+                                nav->node_closed[to] = false;
+                                nav->node_g[to] = UINT32_MAX;
+                        }
+                        if (new_g >= nav->node_g[to]) continue;
+
+                        nav->node_g[to] = new_g;
+                        nav->node_parent[to] = n;
+                        const uint32_t h = to == goal_node ? 0 : hs_nav_heuristic(nav, to, goal);
+                        hs_nav_open_push(&nav->open, new_g + h, to);
+                }
+        }
+        return false;
+}
+
+static inline hs_nav_cache_entry*
+hs_nav_cache_slot(hs_nav* nav, const uint32_t key)
+{
+        return &nav->cache[(key * 2654435761u) >> 24 & (HS_NAV_CACHE_SIZE - 1)];
+}
+
+// fine path in the start room, portal cells through the rooms between and a fine path in the goal room
+static bool
+hs_nav_emit(hs_nav* nav, const hs_grid grid, const vec2i start, const vec2i goal,
+            const uint32_t* chain, const uint32_t count, hs_dynarr* path)
+{
+        hs_dynarr_clear((*path));
+        const hs_nav_node* first = hs_nav_node_get(nav, chain[0]);
+        const hs_nav_node* last = hs_nav_node_get(nav, chain[count - 1]);
+
+        if (!hs_nav_walk(nav, grid, first->room, start, first->cell, path)) return false;
+        for (uint32_t i = 1; i < count; i++) {
+                hs_dynarr_push((*path), vec2i, hs_nav_node_get(nav, chain[i])->cell);
+        }
+        hs_dynarr_pop((*path));
+        return hs_nav_walk(nav, grid, last->room, last->cell, goal, path);
+}
+
+// writes the cells from start to goal into path (a hs_dynarr of vec2i) and returns how many.
+// the start and goal rooms get every cell, the rooms between only their portal cells,
+// search again from inside a room for the full path through it.
+// routes between two rooms are cached, later queries between them reuse the same portals
+uint32_t
+hs_nav_path(hs_nav* nav, const hs_grid grid, const vec2i start, const vec2i goal, hs_dynarr* path)
+{
+        hs_dynarr_clear((*path));
+        if (start.x < 0 || start.y < 0 || start.x >= (int32_t)nav->width || start.y >= (int32_t)nav->height ||
+            goal.x < 0 || goal.y < 0 || goal.x >= (int32_t)nav->width || goal.y >= (int32_t)nav->height)
+                return 0;
+
+        const uint16_t rs = nav->room_of[start.x + start.y * nav->width];
+        const uint16_t rg = nav->room_of[goal.x + goal.y * nav->width];
+        if (rs == HS_NAV_NO_ROOM || rg == HS_NAV_NO_ROOM ||
+            hs_grid_get(grid, start.x, start.y) || hs_grid_get(grid, goal.x, goal.y))
+                return 0;
+
+        if (rs == rg && hs_nav_walk(nav, grid, rs, start, goal, path)) return path->len;
+
+        const uint32_t key = (uint32_t)rs << 16 | rg;
+        hs_nav_cache_entry* entry = hs_nav_cache_slot(nav, key);
+        if (entry->key == key) {
+                const uint32_t* chain = &hs_dynarr_idx(nav->cache_nodes, uint32_t, entry->start);
+                if (hs_nav_emit(nav, grid, start, goal, chain, entry->count, path)) return path->len;
+        }
+
+        // a cached route can start in a part of the room that start cannot reach, search again
+        if (!hs_nav_search(nav, grid, start, goal, rs, rg)) {
+                hs_dynarr_clear((*path));
+                return 0;
+        }
+
+        if (nav->cache_nodes.len + nav->chain.len > HS_NAV_CACHE_MAX_NODES) hs_nav_cache_clear(nav);
+        *entry = (hs_nav_cache_entry){.key = key, .start = nav->cache_nodes.len, .count = nav->chain.len};
+        for (uint32_t i = 0; i < nav->chain.len; i++) {
+                hs_dynarr_push(nav->cache_nodes, uint32_t, hs_dynarr_idx(nav->chain, uint32_t, i));
+        }
+
+        const bool found = hs_nav_emit(nav, grid, start, goal, hs_dynarr_data(nav->chain, uint32_t), nav->chain.len, path);
+        assert(found);
+        return path->len;
+}
+
+#endif // HS_NAV_IMPL
+
+#define HS_NAV_H_
+#endif // HS_NAV_H_
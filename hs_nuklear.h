@@ -14,10 +14,55 @@
 #include "external/nuklear/nuklear.h"
 #include "external/nuklear_glfw_gl3.h"
 
+#define HS_NK_PERF_SAMPLES 128
+#define HS_NK_PERF_OVERLAY_INIT(init_flags) {.flags = init_flags}
+
+typedef struct {
+        float frametimes[HS_NK_PERF_SAMPLES];
+        uint32_t sample;
+        uint32_t flags; // the hs_init_flags currently in use
+} hs_nk_perf_overlay;
+
+typedef struct {
+        uint32_t elem_count;
+        uint32_t tex;
+        struct nk_rect clip;
+} hs_nk_draw;
+
+// the converted ui of the last frame, drawn again while the commands hash the same
+typedef struct {
+        uint64_t hash;
+        bool valid;
+        uint32_t reused;  // frames in a row drawn without converting
+        hs_dynarr draws;  // hs_nk_draw, in drawing order
+} hs_nk_render_cache;
+
+// a font to bake into the ui atlas, path NULL for the nuklear default font
+typedef struct {
+        const char* path;
+        float size;
+} hs_nk_font_desc;
+
+// small ui images packed into one texture, so a screen of icons needs no texture switches
+typedef struct {
+        uint32_t tex;
+        uint32_t width, height;
+} hs_nk_icon_atlas;
+
 #ifndef NO_STBI
-extern struct nk_image hs_nk_image_load(const char *filename);
-extern struct nk_image hs_nk_image_load_size_info(const char *filename, int* width, int* height);
+extern struct nk_image  hs_nk_image_load(const char *filename);
+extern struct nk_image  hs_nk_image_load_size_info(const char *filename, int* width, int* height);
+extern hs_nk_icon_atlas hs_nk_icon_atlas_create(const char** filenames, const uint32_t count, const uint32_t max_width,
+                                                struct nk_image* images);
 #endif // NO_STBI
+extern void             hs_nk_icon_atlas_free(hs_nk_icon_atlas* atlas);
+
+extern void hs_nk_font_stash(struct nk_glfw* glfw, const char* cache_path, const hs_nk_font_desc* descs,
+                             const uint32_t count, struct nk_font** fonts);
+extern void hs_nk_perf_overlay_draw(struct nk_context* ctx, hs_nk_perf_overlay* overlay);
+extern void hs_nk_render(struct nk_glfw* glfw, hs_nk_render_cache* cache, const enum nk_anti_aliasing AA,
+                         const int max_vertex_buffer, const int max_element_buffer);
+extern void hs_nk_render_cache_free(hs_nk_render_cache* cache);
 
 #ifdef HS_IMPL
 #define HS_NUKLEAR_IMPL
@@ -26,19 +71,565 @@ extern struct nk_image hs_nk_image_load_size_info(const char *filename, int* wid
 #ifdef HS_NUKLEAR_IMPL
 
 #ifndef NO_STBI
+// no mipmaps, ui images are drawn at their size with GL_NEAREST
+static uint32_t
+hs_nk_tex_create(const void* data, const int width, const int height)
+{
+        uint32_t tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        hs_stats_texture_set(tex, (uint64_t)width * height * 4);
+
+        return tex;
+}
+
+static uint8_t*
+hs_nk_image_data(const char *filename, int* width, int* height)
+{
+        int nr_channels;
+        uint8_t* data = stbi_load(filename, width, height, &nr_channels, 4);
+        if (!data) {
+                fprintf(stderr, "---error loading texture \"%s\"---\n", filename);
+                assert(data);
+        }
+        return data;
+}
+
 inline struct nk_image
 hs_nk_image_load(const char *filename)
 {
-    return nk_image_id(hs_tex2d_create(filename, GL_RGBA, GL_CLAMP_TO_EDGE, GL_NEAREST));
+        int width, height;
+        return hs_nk_image_load_size_info(filename, &width, &height);
 }
 
-inline struct nk_image
+struct nk_image
 hs_nk_image_load_size_info(const char *filename, int* width, int* height)
 {
-    return nk_image_id(hs_tex2d_create_size_info(filename, GL_RGBA, GL_CLAMP_TO_EDGE, GL_NEAREST, width, height));
+        uint8_t* data = hs_nk_image_data(filename, width, height);
+        const uint32_t tex = hs_nk_tex_create(data, *width, *height);
+        stbi_image_free(data);
+        return nk_image_id((int)tex);
+}
+
+// shelf packing, tallest images first. images receive sub images of the one texture
+hs_nk_icon_atlas
+hs_nk_icon_atlas_create(const char** filenames, const uint32_t count, const uint32_t max_width,
+                        struct nk_image* images)
+{
+        assert(count);
+        uint8_t** data = malloc(sizeof(uint8_t*) * count);
+        int* sizes = malloc(sizeof(int) * count * 4); // width, height, x, y
+        uint64_t* keys = malloc(sizeof(uint64_t) * count * 2);
+        uint32_t* order = malloc(sizeof(uint32_t) * count * 2);
+        assert(data && sizes && keys && order);
+        hs_alloc_count += 4;
+
+        for (uint32_t i = 0; i < count; i++) {
+                data[i] = hs_nk_image_data(filenames[i], &sizes[i * 4], &sizes[i * 4 + 1]);
+                assert((uint32_t)sizes[i * 4] <= max_width);
+                keys[i] = UINT32_MAX - (uint32_t)sizes[i * 4 + 1];
+                order[i] = i;
+        }
+        hs_radix_sort64(keys, order, keys + count, order + count, count);
+
+        // a texel of space between icons keeps filtering from pulling in the neighbours
+        uint32_t x = 0, y = 0, shelf = 0, width = 0;
+        for (uint32_t i = 0; i < count; i++) {
+                int* size = &sizes[order[i] * 4];
+                if (x + size[0] > max_width) {
+                        y += shelf + 1;
+                        x = shelf = 0;
+                }
+                size[2] = x;
+                size[3] = y;
+                x += size[0] + 1;
+                shelf = max(shelf, (uint32_t)size[1]);
+                width = max(width, x - 1);
+        }
+        const uint32_t height = y + shelf;
+
+        uint8_t* pixels = calloc((size_t)width * height, 4);
+        assert(pixels);
+        hs_alloc_count++;
+        for (uint32_t i = 0; i < count; i++) {
+                const int* size = &sizes[i * 4];
+                for (int row = 0; row < size[1]; row++)
+                        memcpy(pixels + ((size_t)(size[3] + row) * width + size[2]) * 4,
+                               data[i] + (size_t)row * size[0] * 4, (size_t)size[0] * 4);
+                stbi_image_free(data[i]);
+        }
+
+        const hs_nk_icon_atlas atlas = {
+                .tex = hs_nk_tex_create(pixels, width, height),
+                .width = width,
+                .height = height,
+        };
+        for (uint32_t i = 0; i < count; i++) {
+                const int* size = &sizes[i * 4];
+                images[i] = nk_subimage_id((int)atlas.tex, (nk_ushort)width, (nk_ushort)height,
+                                           nk_rect(size[2], size[3], size[0], size[1]));
+        }
+
+        free(pixels);
+        free(data);
+        free(sizes);
+        free(keys);
+        free(order);
+        return atlas;
 }
 #endif // NO_STBI
 
+inline void
+hs_nk_icon_atlas_free(hs_nk_icon_atlas* atlas)
+{
+        hs_tex_delete(atlas->tex);
+        *atlas = (hs_nk_icon_atlas){0};
+}
+
+static uint64_t
+hs_nk_hash_bytes(uint64_t hash, const void* data, const size_t size)
+{
+        const uint8_t* bytes = data;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+                uint64_t word;
+                memcpy(&word, bytes + i, 8);
+                hash = (hash ^ word) * 0x100000001b3ull;
+                hash ^= hash >> 32;
+        }
+        for (; i < size; i++)
+                hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        return hash;
+}
+
+#define HS_NK_FONT_CACHE_MAGIC "hsnkfnt1"
+
+// followed by the fonts, their glyph ranges, the glyphs and the rgba pixels
+typedef struct {
+        char magic[8];
+        uint64_t key;
+        int32_t width, height;
+        uint32_t fonts, ranges, glyphs;
+        struct nk_recti custom;
+        struct nk_cursor cursors[NK_CURSOR_COUNT];
+} hs_nk_font_cache_header;
+
+typedef struct {
+        struct nk_baked_font info; // ranges is pointed at the loaded ranges
+        nk_rune fallback;
+        uint32_t range_start, range_count;
+} hs_nk_font_cache_font;
+
+// the structs are written as they are, so a different nuklear build never matches.
+// reading the font files costs far less than rasterizing them
+static uint64_t
+hs_nk_font_cache_key(const hs_nk_font_desc* descs, const uint32_t count)
+{
+        const uint32_t layout[] = {
+                sizeof(struct nk_font_glyph), sizeof(struct nk_baked_font), sizeof(struct nk_cursor), count
+        };
+        uint64_t hash = hs_nk_hash_bytes(0xcbf29ce484222325ull, layout, sizeof(layout));
+
+        for (uint32_t i = 0; i < count; i++) {
+                hash = hs_nk_hash_bytes(hash, &descs[i].size, sizeof(float));
+                if (!descs[i].path) {
+                        hash = hs_nk_hash_bytes(hash, "default", 8);
+                        continue;
+                }
+                hash = hs_nk_hash_bytes(hash, descs[i].path, strlen(descs[i].path) + 1);
+
+                FILE* file = fopen(descs[i].path, "rb");
+                if (!file) continue;
+                uint8_t buffer[4096];
+                size_t n;
+                while ((n = fread(buffer, 1, sizeof(buffer), file)))
+                        hash = hs_nk_hash_bytes(hash, buffer, n);
+                fclose(file);
+        }
+        return hash;
+}
+
+// rebuilds the fonts nk_font_atlas_bake would have made, the pixels are left in atlas->pixel
+static bool
+hs_nk_font_cache_load(struct nk_font_atlas* atlas, const char* cache_path, const uint64_t key,
+                      const hs_nk_font_desc* descs, const uint32_t count, struct nk_font** fonts)
+{
+        FILE* file = fopen(cache_path, "rb");
+        if (!file) return false;
+
+        hs_nk_font_cache_header header;
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            memcmp(header.magic, HS_NK_FONT_CACHE_MAGIC, 8) || header.key != key || header.fonts != count) {
+                fclose(file);
+                return false;
+        }
+
+        const size_t pixel_bytes = (size_t)header.width * header.height * 4;
+        hs_nk_font_cache_font* cached = malloc(sizeof(hs_nk_font_cache_font) * count);
+        nk_rune* ranges = malloc(sizeof(nk_rune) * header.ranges);
+        struct nk_font_glyph* glyphs = atlas->permanent.alloc(atlas->permanent.userdata, 0,
+                                                              sizeof(struct nk_font_glyph) * header.glyphs);
+        void* pixels = atlas->temporary.alloc(atlas->temporary.userdata, 0, pixel_bytes);
+        assert(cached && ranges && glyphs && pixels);
+        hs_alloc_count += 2;
+
+        const bool complete = fread(cached, sizeof(hs_nk_font_cache_font), count, file) == count &&
+                              fread(ranges, sizeof(nk_rune), header.ranges, file) == header.ranges &&
+                              fread(glyphs, sizeof(struct nk_font_glyph), header.glyphs, file) == header.glyphs &&
+                              fread(pixels, 1, pixel_bytes, file) == pixel_bytes;
+        fclose(file);
+        if (!complete) {
+                atlas->permanent.free(atlas->permanent.userdata, glyphs);
+                atlas->temporary.free(atlas->temporary.userdata, pixels);
+                free(cached);
+                free(ranges);
+                return false;
+        }
+
+        atlas->glyphs = glyphs;
+        atlas->glyph_count = (int)header.glyphs;
+        atlas->pixel = pixels;
+        atlas->tex_width = header.width;
+        atlas->tex_height = header.height;
+        atlas->custom = header.custom;
+        memcpy(atlas->cursors, header.cursors, sizeof(header.cursors));
+
+        // nk_font_find_glyph walks font->config, so every font gets the config
+        // nk_font_atlas_add would have made. the ranges live behind the config
+        struct nk_font_config* last = NULL;
+        for (uint32_t i = 0; i < count; i++) {
+                const size_t range_bytes = sizeof(nk_rune) * cached[i].range_count;
+                struct nk_font_config* config = atlas->permanent.alloc(atlas->permanent.userdata, 0,
+                                                                       sizeof(struct nk_font_config) + range_bytes);
+                struct nk_font* font = atlas->permanent.alloc(atlas->permanent.userdata, 0, sizeof(struct nk_font));
+                assert(config && font);
+                memset(font, 0, sizeof(struct nk_font));
+                memcpy(config + 1, ranges + cached[i].range_start, range_bytes);
+
+                *config = nk_font_config(descs[i].size);
+                config->range = (const nk_rune*)(config + 1);
+                config->fallback_glyph = cached[i].fallback;
+                config->font = &font->info;
+                config->n = config;
+                config->p = config;
+                config->next = NULL;
+                font->config = config;
+
+                struct nk_baked_font info = cached[i].info;
+                info.ranges = config->range;
+                nk_font_init(font, descs[i].size, cached[i].fallback, glyphs, &info, nk_handle_ptr(0));
+
+                // in the order nk_font_atlas_add links them
+                if (last) last->next = config;
+                else atlas->config = config;
+                last = config;
+                if (i) fonts[i - 1]->next = font;
+                else atlas->fonts = font;
+                fonts[i] = font;
+        }
+        atlas->font_num = (int)count;
+        atlas->default_font = fonts[0];
+
+        free(cached);
+        free(ranges);
+        return true;
+}
+
+static void
+hs_nk_font_cache_save(const struct nk_font_atlas* atlas, const char* cache_path, const uint64_t key,
+                      struct nk_font** fonts, const uint32_t count, const void* pixels)
+{
+        hs_nk_font_cache_font* cached = malloc(sizeof(hs_nk_font_cache_font) * count);
+        assert(cached);
+        hs_alloc_count++;
+
+        uint32_t range_total = 0;
+        for (uint32_t i = 0; i < count; i++) {
+                // pairs of first and last codepoint, ended by a zero
+                uint32_t n = 0;
+                while (fonts[i]->info.ranges[n]) n += 2;
+                cached[i] = (hs_nk_font_cache_font){
+                        .info = fonts[i]->info,
+                        .fallback = fonts[i]->fallback_codepoint,
+                        .range_start = range_total,
+                        .range_count = n + 1,
+                };
+                cached[i].info.ranges = NULL;
+                range_total += n + 1;
+        }
+
+        hs_nk_font_cache_header header = {
+                .key = key,
+                .width = atlas->tex_width,
+                .height = atlas->tex_height,
+                .fonts = count,
+                .ranges = range_total,
+                .glyphs = (uint32_t)atlas->glyph_count,
+                .custom = atlas->custom,
+        };
+        memcpy(header.magic, HS_NK_FONT_CACHE_MAGIC, 8);
+        memcpy(header.cursors, atlas->cursors, sizeof(header.cursors));
+
+        FILE* file = fopen(cache_path, "wb");
+        if (!file) {
+                fprintf(stderr, "---error writing font cache \"%s\"---\n", cache_path);
+                free(cached);
+                return;
+        }
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(cached, sizeof(hs_nk_font_cache_font), count, file);
+        for (uint32_t i = 0; i < count; i++)
+                fwrite(fonts[i]->info.ranges, sizeof(nk_rune), cached[i].range_count, file);
+        fwrite(atlas->glyphs, sizeof(struct nk_font_glyph), (size_t)atlas->glyph_count, file);
+        fwrite(pixels, 1, (size_t)atlas->tex_width * atlas->tex_height * 4, file);
+        fclose(file);
+        free(cached);
+}
+
+// nk_glfw3_font_stash_begin/end for the fonts in descs, which are only baked when
+// cache_path holds no atlas for these files and sizes. fonts[0] becomes the style font
+void
+hs_nk_font_stash(struct nk_glfw* glfw, const char* cache_path, const hs_nk_font_desc* descs,
+                 const uint32_t count, struct nk_font** fonts)
+{
+        assert(count);
+        struct nk_font_atlas* atlas;
+        nk_glfw3_font_stash_begin(glfw, &atlas);
+
+        const uint64_t key = hs_nk_font_cache_key(descs, count);
+        const void* pixels;
+        int width, height;
+        if (hs_nk_font_cache_load(atlas, cache_path, key, descs, count, fonts)) {
+                pixels = atlas->pixel;
+                width = atlas->tex_width;
+                height = atlas->tex_height;
+        } else {
+                for (uint32_t i = 0; i < count; i++) {
+                        fonts[i] = descs[i].path ?
+                                nk_font_atlas_add_from_file(atlas, descs[i].path, descs[i].size, NULL) :
+                                nk_font_atlas_add_default(atlas, descs[i].size, NULL);
+                        if (!fonts[i]) {
+                                fprintf(stderr, "---error loading font \"%s\"---\n", descs[i].path ? descs[i].path : "default");
+                                assert(fonts[i]);
+                        }
+                }
+                pixels = nk_font_atlas_bake(atlas, &width, &height, NK_FONT_ATLAS_RGBA32);
+                hs_nk_font_cache_save(atlas, cache_path, key, fonts, count, pixels);
+        }
+
+        nk_glfw3_device_upload_atlas(glfw, pixels, width, height);
+        hs_stats_texture_set(glfw->ogl.font_tex, (uint64_t)width * height * 4);
+        nk_font_atlas_end(atlas, nk_handle_id((int)glfw->ogl.font_tex), &glfw->ogl.null);
+        nk_style_set_font(&glfw->ctx, &fonts[0]->handle);
+}
+
+void
+hs_nk_perf_overlay_draw(struct nk_context* ctx, hs_nk_perf_overlay* overlay)
+{
+        const hs_frame_stats stats = hs_stats_last_frame();
+        overlay->frametimes[overlay->sample++ % HS_NK_PERF_SAMPLES] = stats.frametime;
+
+        float max_frametime = 0.0f, avg_frametime = 0.0f;
+        for (uint32_t i = 0; i < HS_NK_PERF_SAMPLES; i++) {
+                max_frametime = max(max_frametime, overlay->frametimes[i]);
+                avg_frametime += overlay->frametimes[i];
+        }
+        avg_frametime /= HS_NK_PERF_SAMPLES;
+
+        if (nk_begin(ctx, "performance", nk_rect(10, 10, 280, 340),
+                     NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE |
+                     NK_WINDOW_MINIMIZABLE | NK_WINDOW_TITLE)) {
+                nk_layout_row_dynamic(ctx, 18, 1);
+                nk_labelf(ctx, NK_TEXT_LEFT, "frametime: %.2f ms (avg %.2f, max %.2f)",
+                          stats.frametime, avg_frametime, max_frametime);
+
+                nk_layout_row_dynamic(ctx, 60, 1);
+                if (nk_chart_begin(ctx, NK_CHART_LINES, HS_NK_PERF_SAMPLES, 0.0f, max_frametime)) {
+                        // oldest sample first
+                        for (uint32_t i = 0; i < HS_NK_PERF_SAMPLES; i++)
+                                nk_chart_push(ctx, overlay->frametimes[(overlay->sample + i) % HS_NK_PERF_SAMPLES]);
+                        nk_chart_end(ctx);
+                }
+
+                nk_layout_row_dynamic(ctx, 18, 1);
+                nk_labelf(ctx, NK_TEXT_LEFT, "draw calls: %u", stats.draw_calls);
+                nk_labelf(ctx, NK_TEXT_LEFT, "vertices: %u", stats.vertices);
+                nk_labelf(ctx, NK_TEXT_LEFT, "buffer uploads: %.1f KiB", stats.buffer_bytes / 1024.0);
+                nk_labelf(ctx, NK_TEXT_LEFT, "texture memory: %.1f MiB", stats.texture_bytes / (1024.0 * 1024.0));
+                nk_labelf(ctx, NK_TEXT_LEFT, "heap allocations: %u", stats.allocations);
+                nk_labelf(ctx, NK_TEXT_LEFT, "entities: %u", stats.entities);
+#ifdef HS_GL_STATS
+                const hs_gl_stats gl_stats = hs_gl_stats_last_frame();
+                nk_labelf(ctx, NK_TEXT_LEFT, "gl draw calls: %u", gl_stats.draw_calls);
+                nk_labelf(ctx, NK_TEXT_LEFT, "gl state changes: %u", gl_stats.state_changes);
+                nk_labelf(ctx, NK_TEXT_LEFT, "gl uploads: %.1f KiB",
+                          (gl_stats.buffer_upload_bytes + gl_stats.texture_upload_bytes) / 1024.0);
+                nk_labelf(ctx, NK_TEXT_LEFT, "gl memory: %.1f MiB",
+                          (gl_stats.buffer_live_bytes + gl_stats.texture_live_bytes) / (1024.0 * 1024.0));
+#endif
+
+                nk_layout_row_dynamic(ctx, 20, 2);
+                int vsync = !(overlay->flags & HS_NO_VSYNC);
+                if (nk_checkbox_label(ctx, "vsync", &vsync)) {
+                        overlay->flags ^= HS_NO_VSYNC;
+                        glfwSwapInterval(vsync);
+                }
+                int wireframe = overlay->flags & HS_WIREFRAME_MODE;
+                if (nk_checkbox_label(ctx, "wireframe", &wireframe)) {
+                        overlay->flags ^= HS_WIREFRAME_MODE;
+                        glPolygonMode(GL_FRONT_AND_BACK, wireframe ? GL_LINE : GL_FILL);
+                }
+        }
+        nk_end(ctx);
+}
+
+// the command memory of each window nk_build draws, in z order so a change of window order
+// counts too, then the overlay. popups draw into the memory of their parent window. runs
+// before nk_build relinks the windows, padding that differs only ever causes an extra conversion
+static uint64_t
+hs_nk_commands_hash(struct nk_context* ctx, const enum nk_anti_aliasing AA)
+{
+        const nk_byte* base = nk_buffer_memory_const(&ctx->memory);
+        uint64_t hash = 0xcbf29ce484222325ull ^ AA;
+        for (const struct nk_window* win = ctx->begin; win; win = win->next) {
+                if (win->buffer.last == win->buffer.begin || (win->flags & NK_WINDOW_HIDDEN) ||
+                    win->seq != ctx->seq) continue;
+                const nk_size size = win->buffer.end - win->buffer.begin;
+                hash = (hash ^ size) * 0x100000001b3ull;
+                hash = hs_nk_hash_bytes(hash, base + win->buffer.begin, size);
+        }
+        if (ctx->overlay.end != ctx->overlay.begin) {
+                const nk_size size = ctx->overlay.end - ctx->overlay.begin;
+                hash = (hash ^ size) * 0x100000001b3ull;
+                hash = hs_nk_hash_bytes(hash, base + ctx->overlay.begin, size);
+        }
+        return hash;
+}
+
+// nk_glfw3_render that skips nk_convert and the buffer upload when the ui did not change,
+// the vertex and element buffers still hold the last conversion then
+void
+hs_nk_render(struct nk_glfw* glfw, hs_nk_render_cache* cache, const enum nk_anti_aliasing AA,
+             const int max_vertex_buffer, const int max_element_buffer)
+{
+        struct nk_glfw_device* dev = &glfw->ogl;
+        GLfloat ortho[4][4] = {
+                {2.0f, 0.0f, 0.0f, 0.0f},
+                {0.0f,-2.0f, 0.0f, 0.0f},
+                {0.0f, 0.0f,-1.0f, 0.0f},
+                {-1.0f,1.0f, 0.0f, 1.0f},
+        };
+        ortho[0][0] /= (GLfloat)glfw->width;
+        ortho[1][1] /= (GLfloat)glfw->height;
+
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_SCISSOR_TEST);
+        glActiveTexture(GL_TEXTURE0);
+
+        glUseProgram(dev->prog);
+        glUniform1i(dev->uniform_tex, 0);
+        glUniformMatrix4fv(dev->uniform_proj, 1, GL_FALSE, &ortho[0][0]);
+        glViewport(0, 0, (GLsizei)glfw->display_width, (GLsizei)glfw->display_height);
+
+        glBindVertexArray(dev->vao);
+        glBindBuffer(GL_ARRAY_BUFFER, dev->vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, dev->ebo);
+
+        if (!cache->draws.data) cache->draws = hs_dynarr_init(hs_nk_draw, 64);
+
+        const uint64_t hash = hs_nk_commands_hash(&glfw->ctx, AA);
+        if (cache->valid && hash == cache->hash) {
+                cache->reused++;
+        } else {
+                glBufferData(GL_ARRAY_BUFFER, max_vertex_buffer, NULL, GL_STREAM_DRAW);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, max_element_buffer, NULL, GL_STREAM_DRAW);
+                void* vertices = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+                void* elements = glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+
+                static const struct nk_draw_vertex_layout_element vertex_layout[] = {
+                        {NK_VERTEX_POSITION, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_glfw_vertex, position)},
+                        {NK_VERTEX_TEXCOORD, NK_FORMAT_FLOAT, NK_OFFSETOF(struct nk_glfw_vertex, uv)},
+                        {NK_VERTEX_COLOR, NK_FORMAT_R8G8B8A8, NK_OFFSETOF(struct nk_glfw_vertex, col)},
+                        {NK_VERTEX_LAYOUT_END}
+                };
+                const struct nk_convert_config config = {
+                        .vertex_layout = vertex_layout,
+                        .vertex_size = sizeof(struct nk_glfw_vertex),
+                        .vertex_alignment = NK_ALIGNOF(struct nk_glfw_vertex),
+                        .null = dev->null,
+                        .circle_segment_count = 22,
+                        .curve_segment_count = 22,
+                        .arc_segment_count = 22,
+                        .global_alpha = 1.0f,
+                        .shape_AA = AA,
+                        .line_AA = AA,
+                };
+
+                struct nk_buffer vbuf, ebuf;
+                nk_buffer_init_fixed(&vbuf, vertices, (size_t)max_vertex_buffer);
+                nk_buffer_init_fixed(&ebuf, elements, (size_t)max_element_buffer);
+                nk_convert(&glfw->ctx, &dev->cmds, &vbuf, &ebuf, &config);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+                hs_stats.buffer_bytes += vbuf.needed + ebuf.needed;
+
+                // the draw list lives in nuklear memory that nk_clear hands back, keep a copy
+                hs_dynarr_clear(cache->draws);
+                const struct nk_draw_command* cmd;
+                nk_draw_foreach(cmd, &glfw->ctx, &dev->cmds) {
+                        if (!cmd->elem_count) continue;
+                        hs_dynarr_push(cache->draws, hs_nk_draw, ((hs_nk_draw){
+                                .elem_count = cmd->elem_count,
+                                .tex = (uint32_t)cmd->texture.id,
+                                .clip = cmd->clip_rect,
+                        }));
+                }
+                cache->hash = hash;
+                cache->valid = true;
+                cache->reused = 0;
+        }
+
+        // the scissor follows the current window size, so it is not part of the cache
+        const nk_draw_index* offset = NULL;
+        for (size_t i = 0; i < cache->draws.len; i++) {
+                const hs_nk_draw d = hs_dynarr_idx(cache->draws, hs_nk_draw, i);
+                glBindTexture(GL_TEXTURE_2D, d.tex);
+                glScissor((GLint)(d.clip.x * glfw->fb_scale.x),
+                          (GLint)((glfw->height - (GLint)(d.clip.y + d.clip.h)) * glfw->fb_scale.y),
+                          (GLint)(d.clip.w * glfw->fb_scale.x),
+                          (GLint)(d.clip.h * glfw->fb_scale.y));
+                glDrawElements(GL_TRIANGLES, (GLsizei)d.elem_count, GL_UNSIGNED_SHORT, offset);
+                hs_stats.draw_calls++;
+                offset += d.elem_count;
+        }
+        nk_clear(&glfw->ctx);
+        nk_buffer_clear(&dev->cmds);
+
+        glUseProgram(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+}
+
+inline void
+hs_nk_render_cache_free(hs_nk_render_cache* cache)
+{
+        hs_dynarr_free(cache->draws);
+        *cache = (hs_nk_render_cache){0};
+}
+
 #endif // HS_NUKLEAR_IMPL
 
 #define HS_NUKLEAR_H_
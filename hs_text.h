@@ -0,0 +1,395 @@
+#ifndef HS_TEXT_H_
+#include "hs_graphics.h"
+
+// Text from a pre-baked glyph atlas, a grid of equally sized cells like a tileset.
+// Glyphs are written as instances into one stream buffer and drawn with a single
+// draw call per batch, positions and sizes are in world units like the tilemaps.
+// Lines start at the bottom left corner of the first glyph and go down by size.
+
+#define HS_FONT_GLYPHS 256
+
+enum hs_font_flags {
+        HS_FONT_SDF       = 1 << 0, // alpha holds a distance field with the edge at 0.5
+        HS_FONT_MONOSPACE = 1 << 1, // every glyph advances by the cell width
+};
+
+typedef struct {
+        uint32_t tex;
+        uint32_t columns, rows;        // cells in the atlas
+        uint32_t first, count;         // character in the first cell and cells in use
+        float aspect;                  // cell width over height
+        uint32_t flags;
+        float advance[HS_FONT_GLYPHS]; // per character in line heights
+} hs_font;
+
+// instance data of one glyph
+typedef struct {
+        vec2 pos;
+        float size;
+        uint32_t glyph; // atlas cell
+        uint32_t color; // rgba8, red in the low byte
+} hs_glyph;
+
+// laid out once at size 1 from the run origin, pushing it only moves and scales the glyphs
+typedef struct {
+        hs_glyph* glyphs;
+        uint32_t count;
+        float width, height; // in line heights
+} hs_text_run;
+
+typedef struct {
+        const hs_font* font;
+        hs_shader_program sp; // coord works like the tilemap ones
+        uint32_t max_glyphs, count;
+        hs_glyph* write;
+        hs_stream_buffer stream;
+} hs_text_batch;
+
+/* Fonts */
+extern hs_font  hs_font_create_data(const uint8_t* rgba, const uint32_t width, const uint32_t height,
+                                    const uint32_t columns, const uint32_t rows, const uint32_t first, const uint32_t flags);
+#ifndef NO_STBI
+extern hs_font  hs_font_create(const char* filename, const uint32_t columns, const uint32_t rows,
+                               const uint32_t first, const uint32_t flags);
+#endif // NO_STBI
+extern void     hs_font_free(hs_font* font);
+extern float    hs_text_width(const hs_font* font, const char* str);
+extern uint32_t hs_text_color(const vec4 color);
+
+/* Glyph runs */
+extern hs_text_run hs_text_run_create(const hs_font* font, const char* str);
+extern void        hs_text_run_free(hs_text_run* run);
+
+/* Text batch */
+extern void     hs_text_init(hs_text_batch* b, const hs_font* font, const uint32_t max_glyphs);
+extern void     hs_text_begin(hs_text_batch* b);
+extern float    hs_text_push(hs_text_batch* b, const char* str, const vec2 pos, const float size, const vec4 color);
+extern void     hs_text_push_run(hs_text_batch* b, const hs_text_run run, const vec2 pos, const float size, const vec4 color);
+extern void     hs_text_draw(hs_text_batch* b);
+extern void     hs_text_free(hs_text_batch* b);
+
+#ifdef HS_IMPL
+#define HS_TEXT_IMPL
+#endif //HS_IMPL
+
+#ifdef HS_TEXT_IMPL
+
+// empty cells, like the space, advance by this much of the cell width
+#define HS_FONT_EMPTY_ADVANCE 0.5f
+
+// rgba is top row first, like stbi_load returns it
+hs_font
+hs_font_create_data(const uint8_t* rgba, const uint32_t width, const uint32_t height,
+                    const uint32_t columns, const uint32_t rows, const uint32_t first, const uint32_t flags)
+{
+        assert(columns && rows);
+        hs_font font = {
+                .columns = columns,
+                .rows = rows,
+                .first = first,
+                .count = min(columns * rows, HS_FONT_GLYPHS - first),
+                .aspect = (float)(width / columns) / (height / rows),
+                .flags = flags,
+        };
+
+        // proportional advances from the rightmost covered column of every cell, plus one texel
+        const uint32_t cell_w = width / columns, cell_h = height / rows;
+        const uint8_t coverage = flags & HS_FONT_SDF ? 127 : 0;
+        for (uint32_t c = 0; c < HS_FONT_GLYPHS; c++)
+                font.advance[c] = font.aspect;
+        for (uint32_t g = 0; g < font.count && !(flags & HS_FONT_MONOSPACE); g++) {
+                const uint32_t x0 = (g % columns) * cell_w, y0 = (g / columns) * cell_h;
+                int32_t right = -1;
+                for (uint32_t y = y0; y < y0 + cell_h; y++)
+                        for (int32_t x = cell_w - 1; x > right; x--)
+                                if (rgba[((size_t)y * width + x0 + x) * 4 + 3] > coverage) right = x;
+
+                font.advance[first + g] = right < 0 ? font.aspect * HS_FONT_EMPTY_ADVANCE :
+                                          min((float)(right + 2) / cell_h, font.aspect);
+        }
+
+        const GLenum filter = flags & HS_FONT_SDF ? GL_LINEAR : GL_NEAREST;
+        glGenTextures(1, &font.tex);
+        glBindTexture(GL_TEXTURE_2D, font.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+        hs_stats_texture_set(font.tex, (uint64_t)width * height * 4);
+
+        return font;
+}
+
+#ifndef NO_STBI
+// grey and rgb images without alpha are taken as white glyphs with the coverage in the red
+// channel, grey+alpha and rgba images keep their own alpha
+hs_font
+hs_font_create(const char* filename, const uint32_t columns, const uint32_t rows,
+               const uint32_t first, const uint32_t flags)
+{
+        int width, height, nr_channels;
+        uint8_t* rgba = stbi_load(filename, &width, &height, &nr_channels, 4);
+        if (!rgba) {
+                fprintf(stderr, "---error loading font \"%s\"---\n", filename);
+                assert(rgba);
+        }
+
+        if (nr_channels == 1 || nr_channels == 3) {
+                for (size_t i = 0; i < (size_t)width * height; i++) {
+                        rgba[i * 4 + 3] = rgba[i * 4];
+                        rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 255;
+                }
+        }
+
+        hs_font font = hs_font_create_data(rgba, width, height, columns, rows, first, flags);
+        stbi_image_free(rgba);
+        return font;
+}
+#endif // NO_STBI
+
+inline void
+hs_font_free(hs_font* font)
+{
+        hs_tex_delete(font->tex);
+        font->tex = 0;
+}
+
+// widest line in line heights
+float
+hs_text_width(const hs_font* font, const char* str)
+{
+        float width = 0.0f, line = 0.0f;
+        for (; *str; str++) {
+                if (*str == '\n') {
+                        width = max(width, line);
+                        line = 0.0f;
+                        continue;
+                }
+                line += font->advance[(uint8_t)*str];
+        }
+        return max(width, line);
+}
+
+inline uint32_t
+hs_text_color(const vec4 color)
+{
+        uint32_t packed = 0;
+        for (uint32_t i = 0; i < 4; i++) {
+                float c = color.rgba[i];
+                CLAMP(c, 0.0f, 1.0f);
+                packed |= (uint32_t)(c * 255.0f + 0.5f) << (i * 8);
+        }
+        return packed;
+}
+
+// lays str out at size 1 into glyphs, which has room for strlen(str). returns the glyph count
+static uint32_t
+hs_text_layout(const hs_font* font, const char* str, hs_glyph* glyphs, const uint32_t max_glyphs,
+               const vec2 pos, const float size, const uint32_t color, float* width, float* height)
+{
+        uint32_t count = 0;
+        float x = 0.0f, y = 0.0f, w = 0.0f;
+        for (; *str && count < max_glyphs; str++) {
+                const uint8_t c = *str;
+                if (c == '\n') {
+                        w = max(w, x);
+                        x = 0.0f;
+                        y -= 1.0f;
+                        continue;
+                }
+                if (c >= font->first && c - font->first < font->count)
+                        glyphs[count++] = (hs_glyph){
+                                .pos = {pos.x + x * size, pos.y + y * size},
+                                .size = size,
+                                .glyph = c - font->first,
+                                .color = color,
+                        };
+                x += font->advance[c];
+        }
+        if (width)  *width = max(w, x);
+        if (height) *height = 1.0f - y;
+        return count;
+}
+
+hs_text_run
+hs_text_run_create(const hs_font* font, const char* str)
+{
+        const uint32_t len = strlen(str);
+        hs_text_run run = {0};
+        run.glyphs = malloc(sizeof(hs_glyph) * max(len, 1));
+        assert(run.glyphs);
+        hs_alloc_count++;
+
+        run.count = hs_text_layout(font, str, run.glyphs, len, (vec2){0.0f, 0.0f}, 1.0f, 0xffffffff,
+                                   &run.width, &run.height);
+        return run;
+}
+
+inline void
+hs_text_run_free(hs_text_run* run)
+{
+        free(run->glyphs);
+        *run = (hs_text_run){0};
+}
+
+// one instanced quad per hs_glyph, the atlas is a grid of u_atlas_size cells with
+// the first row at the top of the image
+static const char* text_vert =
+        "#version 330 core\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "layout (location = 1) in float aSize;\n"
+        "layout (location = 2) in uint aGlyph;\n"
+        "layout (location = 3) in vec4 aColor;\n"
+        "out vec2 TexCoord;\n"
+        "out vec4 Color;\n"
+        "uniform vec2 u_model;\n"
+        "uniform vec2 u_view;\n"
+        "uniform mat4 u_proj;\n"
+        "uniform vec2 u_atlas_size;\n"
+        "uniform float u_aspect;\n"
+        "void main()\n"
+        "{\n"
+        "int corner = gl_VertexID % 6;\n"
+        "vec2 far = vec2(corner >= 1 && corner <= 3, corner >= 2 && corner <= 4);\n"
+        "vec2 pos = aPos + far * vec2(u_aspect, 1.0) * aSize;\n"
+        "gl_Position = u_proj * vec4(u_view + u_model + pos, 0.0, 1.0);\n"
+        "uint columns = uint(u_atlas_size.x);\n"
+        "vec2 cell = vec2(aGlyph % columns, aGlyph / columns);\n"
+        "TexCoord = (cell + vec2(far.x, 1.0 - far.y)) / u_atlas_size;\n"
+        "Color = aColor;\n"
+        "}";
+
+// with u_sdf the alpha is a distance field with the edge at 0.5, kept sharp at any size
+static const char* text_frag =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "in vec2 TexCoord;\n"
+        "in vec4 Color;\n"
+        "uniform sampler2D u_tex;\n"
+        "uniform bool u_sdf;\n"
+        "void main()\n"
+        "{\n"
+        "vec4 texel = texture(u_tex, TexCoord);\n"
+        "if (u_sdf) {\n"
+        "        float w = max(fwidth(texel.a), 0.0001);\n"
+        "        texel = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - w, 0.5 + w, texel.a));\n"
+        "}\n"
+        "FragColor = texel * Color;\n"
+        "if (FragColor.a == 0.0) discard;\n"
+        "}";
+
+void
+hs_text_init(hs_text_batch* b, const hs_font* font, const uint32_t max_glyphs)
+{
+        assert(max_glyphs);
+        *b = (hs_text_batch){.font = font, .max_glyphs = max_glyphs};
+
+        b->sp.p = hs_sp_create_from_src(text_vert, text_frag);
+        b->sp.coord = hs_uniform_coord_create(b->sp.p, "u_model", "u_view", "u_proj");
+        hs_uniform_mat4_set(b->sp.coord.proj, (mat4)MAT4_IDENTITY);
+        hs_tex_uniform_set(hs_uniform_create(b->sp.p, "u_tex"), 0);
+        hs_uniform_vec2_set(hs_uniform_create(b->sp.p, "u_atlas_size"), (vec2){font->columns, font->rows});
+        glUniform1f(hs_uniform_create(b->sp.p, "u_aspect"), font->aspect);
+        glUniform1i(hs_uniform_create(b->sp.p, "u_sdf"), (font->flags & HS_FONT_SDF) != 0);
+
+        // the attribute pointers move with the stream section, hs_text_draw sets them
+        b->sp.vobj.vao = hs_vao_create(1);
+        hs_stream_buffer_init(&b->stream, sizeof(hs_glyph) * max_glyphs, sizeof(hs_glyph));
+        b->sp.vobj.vbo = b->stream.vbo;
+        for (uint32_t i = 0; i < 4; i++) {
+                glEnableVertexAttribArray(i);
+                glVertexAttribDivisor(i, 1);
+        }
+
+        b->write = hs_stream_buffer_begin(&b->stream, b->stream.size);
+}
+
+// once per frame before pushing text, the text of the last frame is dropped
+void
+hs_text_begin(hs_text_batch* b)
+{
+        if (b->write) hs_stream_buffer_end(&b->stream, 0);
+        hs_stream_buffer_frame_end(&b->stream);
+        b->write = hs_stream_buffer_begin(&b->stream, b->stream.size);
+        b->count = 0;
+}
+
+static inline bool
+hs_text_reserve(hs_text_batch* b, const uint32_t glyphs)
+{
+        assert(b->write);
+        if (b->count + glyphs > b->max_glyphs) {
+                fprintf(stderr, "---error text batch holds %u glyphs, %u are in use and %u more were pushed---\n",
+                        b->max_glyphs, b->count, glyphs);
+                assert(b->count + glyphs <= b->max_glyphs);
+                return false;
+        }
+        return true;
+}
+
+// returns the width of the widest line in world units
+float
+hs_text_push(hs_text_batch* b, const char* str, const vec2 pos, const float size, const vec4 color)
+{
+        const uint32_t len = strlen(str);
+        if (!hs_text_reserve(b, len)) return 0.0f;
+
+        float width;
+        b->count += hs_text_layout(b->font, str, b->write + b->count, len, pos, size, hs_text_color(color),
+                                   &width, NULL);
+        return width * size;
+}
+
+void
+hs_text_push_run(hs_text_batch* b, const hs_text_run run, const vec2 pos, const float size, const vec4 color)
+{
+        if (!hs_text_reserve(b, run.count)) return;
+
+        const uint32_t packed = hs_text_color(color);
+        hs_glyph* dst = b->write + b->count;
+        for (uint32_t i = 0; i < run.count; i++)
+                dst[i] = (hs_glyph){
+                        .pos = {pos.x + run.glyphs[i].pos.x * size, pos.y + run.glyphs[i].pos.y * size},
+                        .size = size,
+                        .glyph = run.glyphs[i].glyph,
+                        .color = packed,
+                };
+        b->count += run.count;
+}
+
+// binds the font atlas to unit 0 and draws every glyph pushed since hs_text_begin
+void
+hs_text_draw(hs_text_batch* b)
+{
+        const uint32_t first = hs_stream_buffer_end(&b->stream, sizeof(hs_glyph) * b->count);
+        b->write = NULL;
+        if (!b->count) return;
+
+        hs_sp_use(b->sp);
+        hs_tex2d_activate(b->font->tex, GL_TEXTURE0);
+        glBindBuffer(GL_ARRAY_BUFFER, b->stream.vbo);
+        const size_t offset = (size_t)first * sizeof(hs_glyph);
+        hs_vattrib_enable(0, 2, GL_FLOAT, sizeof(hs_glyph), offset + offsetof(hs_glyph, pos));
+        hs_vattrib_enable(1, 1, GL_FLOAT, sizeof(hs_glyph), offset + offsetof(hs_glyph, size));
+        hs_vattrib_enable_int(2, 1, GL_UNSIGNED_INT, sizeof(hs_glyph), offset + offsetof(hs_glyph, glyph));
+        hs_vattrib_enable_norm(3, 4, GL_UNSIGNED_BYTE, sizeof(hs_glyph), offset + offsetof(hs_glyph, color));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, b->count);
+        hs_stats.draw_calls++;
+        hs_stats.vertices += 6 * b->count;
+}
+
+void
+hs_text_free(hs_text_batch* b)
+{
+        if (b->write) hs_stream_buffer_end(&b->stream, 0);
+        hs_stream_buffer_free(&b->stream);
+        glDeleteVertexArrays(1, &b->sp.vobj.vao);
+        glDeleteProgram(b->sp.p);
+        *b = (hs_text_batch){0};
+}
+
+#endif // HS_TEXT_IMPL
+
+#define HS_TEXT_H_
+#endif // HS_TEXT_H_
@@ -7,6 +7,16 @@
 #include <string.h>
 #include <stdio.h>
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// splits [0, count) in contiguous ranges, one per thread
+typedef void (*hs_parallel_func)(void* data, const uint32_t begin, const uint32_t end);
+
 typedef struct {
         size_t cap, len;
         void* data;
@@ -32,11 +42,16 @@ typedef struct {
 #define hs_dynarr_front(_arr, _type) hs_dynarr_idx(_arr, _type, _arr.len - 1)
 #define hs_dynarr_back(_arr, _type) hs_dynarr_idx(_arr, _type, 0)
 
+// heap allocations made by hs, read and reset once per frame for statistics.
+// one counter for the program, the dynarr macros count from every translation unit
+extern uint32_t hs_alloc_count;
+
 static inline hs_dynarr
 _hs_dynarr_init_sz(size_t type_size, const size_t capacity)
 {
         void* data = malloc(type_size * capacity);
         assert(data);
+        hs_alloc_count++;
 
         return (hs_dynarr){
                 .cap  = capacity,
@@ -50,6 +65,7 @@ _hs_dynarr_resize(hs_dynarr* dynarr, const size_t type_size, const size_t new_ca
         if (new_cap > dynarr->cap) {
                 void* new_data = malloc(type_size * new_cap);
                 assert(new_data);
+                hs_alloc_count++;
 
                 memcpy(new_data, dynarr->data, dynarr->cap * type_size);
                 free(dynarr->data);
@@ -63,12 +79,19 @@ extern void hs_memsetv(void* restrict dst, const size_t num, void* restrict src,
 extern char*    hs_file_read_null_term(const char *file_path);
 extern uint8_t* hs_file_read(const char *file_path);
 
+extern uint32_t hs_cpu_count();
+extern void     hs_parallel_for(const uint32_t count, uint32_t threads, hs_parallel_func func, void* data);
+
+extern void     hs_radix_sort64(uint64_t* keys, uint32_t* values, uint64_t* tmp_keys, uint32_t* tmp_values, const uint32_t count);
+
 #ifdef HS_IMPL
 #define HS_UTIL_IMPL
 #endif // HS_IMPL
 
 #ifdef HS_UTIL_IMPL
 
+uint32_t hs_alloc_count = 0;
+
 void
 hs_memsetv(void* restrict dst, const size_t num, void* restrict src, const size_t sz)
 {
@@ -92,6 +115,7 @@ hs_file_read_null_term(const char *file_path)
 
         char* buffer = malloc(readsize + 1);
         assert(buffer);
+        hs_alloc_count++;
 
         fread(buffer, 1, readsize, file);
         buffer[readsize] = '\0';
@@ -101,7 +125,7 @@ hs_file_read_null_term(const char *file_path)
 }
 
 uint8_t*
-hs_file_read_(const char *file_path)
+hs_file_read(const char *file_path)
 {
         FILE *file = fopen(file_path, "r");
         if (!file) {
@@ -115,6 +139,7 @@ hs_file_read_(const char *file_path)
 
         uint8_t* buffer = malloc(readsize);
         assert(buffer);
+        hs_alloc_count++;
 
         fread(buffer, 1, readsize, file);
 
@@ -122,6 +147,166 @@ hs_file_read_(const char *file_path)
         return buffer;
 }
 
+uint32_t
+hs_cpu_count()
+{
+#ifdef WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors;
+#else
+        const long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? count : 1;
+#endif
+}
+
+typedef struct {
+        hs_parallel_func func;
+        void* data;
+        uint32_t begin, end;
+} hs_parallel_job;
+
+#ifdef WIN32
+static DWORD WINAPI
+hs_parallel_thread(LPVOID arg)
+{
+        hs_parallel_job* job = arg;
+        job->func(job->data, job->begin, job->end);
+        return 0;
+}
+#else
+static void*
+hs_parallel_thread(void* arg)
+{
+        hs_parallel_job* job = arg;
+        job->func(job->data, job->begin, job->end);
+        return NULL;
+}
+#endif
+
+// threads == 0 uses every cpu, the calling thread does the first range itself
+void
+hs_parallel_for(const uint32_t count, uint32_t threads, hs_parallel_func func, void* data)
+{
+        if (!threads) threads = hs_cpu_count();
+        if (threads > count) threads = count;
+        if (threads <= 1) {
+                if (count) func(data, 0, count);
+                return;
+        }
+
+        hs_parallel_job* jobs = malloc(sizeof(hs_parallel_job) * threads);
+        assert(jobs);
+        hs_alloc_count++;
+
+        const uint32_t per_thread = count / threads;
+        const uint32_t remainder = count % threads;
+        uint32_t begin = 0;
+        for (uint32_t i = 0; i < threads; i++) {
+                const uint32_t end = begin + per_thread + (i < remainder);
+                jobs[i] = (hs_parallel_job){func, data, begin, end};
+                begin = end;
+        }
+
+#ifdef WIN32
+        HANDLE* handles = malloc(sizeof(HANDLE) * threads);
+        assert(handles);
+        for (uint32_t i = 1; i < threads; i++) {
+                handles[i] = CreateThread(NULL, 0, hs_parallel_thread, &jobs[i], 0, NULL);
+                // no thread for this range, the calling thread does it
+                if (!handles[i]) func(data, jobs[i].begin, jobs[i].end);
+        }
+        func(data, jobs[0].begin, jobs[0].end);
+        for (uint32_t i = 1; i < threads; i++) {
+                if (!handles[i]) continue;
+                WaitForSingleObject(handles[i], INFINITE);
+                CloseHandle(handles[i]);
+        }
+#else
+        pthread_t* handles = malloc(sizeof(pthread_t) * threads);
+        uint8_t* started = malloc(threads);
+        assert(handles && started);
+        for (uint32_t i = 1; i < threads; i++) {
+                started[i] = pthread_create(&handles[i], NULL, hs_parallel_thread, &jobs[i]) == 0;
+                // no thread for this range, the calling thread does it
+                if (!started[i]) func(data, jobs[i].begin, jobs[i].end);
+        }
+        func(data, jobs[0].begin, jobs[0].end);
+        for (uint32_t i = 1; i < threads; i++)
+                if (started[i]) pthread_join(handles[i], NULL);
+        free(started);
+#endif
+
+        free(handles);
+        free(jobs);
+}
+
+// below this insertion sort beats clearing the histograms
+#define HS_RADIX_SORT_MIN 64
+
+// stable sort of keys carrying values along, LSD over 8 bit digits. tmp_keys and
+// tmp_values hold count elements each, digits every key shares are skipped
+void
+hs_radix_sort64(uint64_t* keys, uint32_t* values, uint64_t* tmp_keys, uint32_t* tmp_values, const uint32_t count)
+{
+        if (count < HS_RADIX_SORT_MIN) {
+                for (uint32_t i = 1; i < count; i++) {
+                        const uint64_t key = keys[i];
+                        const uint32_t value = values[i];
+                        uint32_t j = i;
+                        for (; j > 0 && keys[j - 1] > key; j--) {
+                                keys[j] = keys[j - 1];
+                                values[j] = values[j - 1];
+                        }
+                        keys[j] = key;
+                        values[j] = value;
+                }
+                return;
+        }
+
+        // every digit is counted in one pass over the keys
+        uint32_t hist[8][256] = {0};
+        for (uint32_t i = 0; i < count; i++) {
+                const uint64_t key = keys[i];
+                for (uint32_t d = 0; d < 8; d++)
+                        hist[d][(key >> (d * 8)) & 0xff]++;
+        }
+
+        const uint64_t first = keys[0];
+        uint64_t* src_keys = keys;
+        uint32_t* src_values = values;
+        uint64_t* dst_keys = tmp_keys;
+        uint32_t* dst_values = tmp_values;
+        for (uint32_t d = 0; d < 8; d++) {
+                const uint32_t shift = d * 8;
+                if (hist[d][(first >> shift) & 0xff] == count) continue;
+
+                uint32_t offset = 0;
+                for (uint32_t b = 0; b < 256; b++) {
+                        const uint32_t n = hist[d][b];
+                        hist[d][b] = offset;
+                        offset += n;
+                }
+                for (uint32_t i = 0; i < count; i++) {
+                        const uint32_t dst = hist[d][(src_keys[i] >> shift) & 0xff]++;
+                        dst_keys[dst] = src_keys[i];
+                        dst_values[dst] = src_values[i];
+                }
+
+                uint64_t* swap_keys = src_keys;
+                uint32_t* swap_values = src_values;
+                src_keys = dst_keys;
+                src_values = dst_values;
+                dst_keys = swap_keys;
+                dst_values = swap_values;
+        }
+
+        if (src_keys != keys) {
+                memcpy(keys, src_keys, sizeof(uint64_t) * count);
+                memcpy(values, src_values, sizeof(uint32_t) * count);
+        }
+}
+
 #undef HS_UTIL_IMPL
 #endif // HS_UTIL_IMPL
 